@@ -393,6 +393,39 @@ void aes256_decrypt_ecb(const uint8_t deckey[32], uint8_t buf[16])
 #endif // LILLIB_CFG_AES_256
 
 
+#ifdef LILLIB_AES_CTR
+
+// Makes the key for aes128_ctr: expanded for the AVR asm core, as is for aes128_encrypt_ecb
+void aes128_ctr_key(const uint8_t key[16], uint8_t ctrkey[AES128_CTR_KEY_SIZE])
+{
+#if defined(__AVR__) && defined(LILLIB_CFG_AES_AVR_ASM)
+	aes128_avr_expand_key(key, ctrkey);
+#else
+	index_t i;
+	for (i=0; i<16; i++) ctrkey[i] = key[i];
+#endif
+}
+
+// En/decrypts n blocks of data in place, stepping ctr once per block
+void aes128_ctr(const uint8_t *ctrkey, uint8_t ctr[16], uint8_t *data, uint8_t n)
+{
+#if defined(__AVR__) && defined(LILLIB_CFG_AES_AVR_ASM)
+	if (n) aes128_avr_encrypt_ctr(ctrkey, ctr, data, n); // It would take n=0 as 256
+#else
+	uint8_t ks[16];
+	index_t i;
+	for ( ; n; n--, data+=16)
+	{
+		for (i=0; i<16; i++) ks[i] = ctr[i];
+		aes128_encrypt_ecb(ctrkey, ks);
+		for (i=0; i<16; i++) data[i] ^= ks[i];
+		for (i=16; i>12 && !++ctr[i-1]; i--);
+	}
+#endif
+}
+
+#endif // LILLIB_AES_CTR
+
 
 #ifdef LILLIB_CFG_AES_SBOX_TABLES
 #ifdef LILLIB_AES_COMMON
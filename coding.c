@@ -1,13 +1,89 @@
-#include <ctype.h>
 #include "lillib.h"
 
 static const char *b16_chars = "0123456789ABCDEF";
 static const char *b64_chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+static const char z85_chars[86] PROGMEM = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ.-:+=^!/*?&<>()[]{}@%$#";
 
-int b16_encode(const uint8_t *in, int isize, char *out, int osize, int linewidth)
+// Decoding tables, from each char to its value, or W for whitespace (skipped) or E for anything else, which
+// ends the input (including the NUL and b64's '=' padding)
+#define W 0xFE
+#define E 0xFF
+static const uint8_t b16_values[256] PROGMEM = {
+	 E,  E,  E,  E,  E,  E,  E,  E,  E,  W,  W,  W,  W,  W,  E,  E,
+	 E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,
+	 W,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,
+	 0,  1,  2,  3,  4,  5,  6,  7,  8,  9,  E,  E,  E,  E,  E,  E,
+	 E, 10, 11, 12, 13, 14, 15,  E,  E,  E,  E,  E,  E,  E,  E,  E,
+	 E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,
+	 E, 10, 11, 12, 13, 14, 15,  E,  E,  E,  E,  E,  E,  E,  E,  E,
+	 E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,
+	 E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,
+	 E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,
+	 E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,
+	 E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,
+	 E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,
+	 E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,
+	 E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,
+	 E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,
+};
+
+static const uint8_t b64_values[256] PROGMEM = {
+	 E,  E,  E,  E,  E,  E,  E,  E,  E,  W,  W,  W,  W,  W,  E,  E,
+	 E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,
+	 W,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E, 62,  E,  E,  E, 63,
+	52, 53, 54, 55, 56, 57, 58, 59, 60, 61,  E,  E,  E,  E,  E,  E,
+	 E,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+	15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25,  E,  E,  E,  E,  E,
+	 E, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+	41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51,  E,  E,  E,  E,  E,
+	 E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,
+	 E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,
+	 E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,
+	 E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,
+	 E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,
+	 E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,
+	 E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,
+	 E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,
+};
+static const uint8_t z85_values[256] PROGMEM = {
+	 E,  E,  E,  E,  E,  E,  E,  E,  E,  W,  W,  W,  W,  W,  E,  E,
+	 E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,
+	 W, 68,  E, 84, 83, 82, 72,  E, 75, 76, 70, 65,  E, 63, 62, 69,
+	 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 64,  E, 73, 66, 74, 71,
+	81, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50,
+	51, 52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 77,  E, 78, 67,  E,
+	 E, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24,
+	25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 79,  E, 80,  E,  E,
+	 E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,
+	 E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,
+	 E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,
+	 E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,
+	 E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,
+	 E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,
+	 E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,
+	 E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,  E,
+};
+#undef W
+#undef E
+#define CODING_SKIP 0xFE
+#define b16_value(c) pgm_read_byte(&b16_values[(uint8_t)(c)])
+#define b64_value(c) pgm_read_byte(&b64_values[(uint8_t)(c)])
+#define z85_value(c) pgm_read_byte(&z85_values[(uint8_t)(c)])
+
+// The codecs stream: init, then update with each piece of the input, then final for anything left.  Each
+// update's out needs room for all it can produce from its input (and what's left from the last one), and
+// anything that doesn't fit is lost.  The one-shot functions are just the three in a row.
+
+void b16_enc_init(b16_enc *s, int linewidth)
 {
-	int n=0, w=0;
-	while (n<osize && isize--)
+	s->linewidth = linewidth, s->w = 0;
+}
+
+// Two chars per byte, and a '\n' after each linewidth chars (if linewidth>0).  Returns the number of chars.
+int b16_enc_update(b16_enc *s, const uint8_t *in, int isize, char *out, int osize)
+{
+	int n=0, w=s->w, linewidth=s->linewidth;
+	while (n<osize && isize-->0)
 	{
 		uint8_t v = *in++;
 		out[n++] = b16_chars[v>>4];
@@ -16,34 +92,117 @@ int b16_encode(const uint8_t *in, int isize, char *out, int osize, int linewidth
 		out[n++] = b16_chars[v&0xF];
 		if (linewidth>0 && ++w>=linewidth && n<osize) out[n++]='\n', w=0;
 	}
-	if (n<osize) out[n] = 0;
+	s->w = w;
 	return n;
 }
 
-int b16_decode(const char *in, int isize, uint8_t *out, int osize)
+// Nothing is left over, it just NUL terminates if there is room
+int b16_enc_final(b16_enc *s, char *out, int osize)
+{
+	(void)s;
+	if (osize>0) out[0] = 0;
+	return 0;
+}
+
+int b16_encode(const uint8_t *in, int isize, char *out, int osize, int linewidth)
+{
+	b16_enc s;
+	int n;
+	b16_enc_init(&s, linewidth);
+	n = b16_enc_update(&s, in, isize, out, osize);
+	return n + b16_enc_final(&s, out+n, osize-n);
+}
+
+void b16_dec_init(b16_dec *s)
+{
+	s->half = 0, s->done = 0;
+}
+
+// Hex digits (either case) to bytes, skipping whitespace, up to the first other char (after which done is set
+// and the rest of the input is ignored), or isize chars (isize<0 for all of a NUL terminated in).  Returns
+// the number of bytes.
+int b16_dec_update(b16_dec *s, const char *in, int isize, uint8_t *out, int osize)
 {
-	char c;
 	int n=0;
-	uint8_t v=0, b=0, t;
-	while ((c=*in++)!=0 && n<osize && isize--)
+	uint8_t hi, lo, t, v=s->v, half=s->half;
+	if (s->done) return 0;
+	if (isize<0) isize = (int)(~0u>>1);
+	while (n<osize && isize)
 	{
-		if      (c>='A' && c<='Z') t = c-'A'+10;
-		else if (c>='a' && c<='z') t = c-'a'+10;
-		else if (c>='0' && c<='9') t = c-'0';
-		else if (isspace((uint8_t)c)) continue;
-		else break;
-		b += 4;
-		v  = (v<<4)|t;
-		if (b>=8)
+		// Whole bytes while there are two digits together, then one char at a time around anything else
+		if (!half && isize>=2 && (hi=b16_value(in[0]))<16 && (lo=b16_value(in[1]))<16)
 		{
-			b -= 8;
-			*out++ = v;
-			n++;
+			out[n++] = hi<<4 | lo;
+			in += 2, isize -= 2;
+			continue;
 		}
+		t = b16_value(*in++), isize--;
+		if (t==CODING_SKIP) continue;
+		if (t>CODING_SKIP) { s->done = 1; break; }
+		if (half) out[n++] = v<<4 | t, half = 0;
+		else v = t, half = 1;
 	}
+	s->v = v, s->half = half;
 	return n;
 }
 
+// An odd last digit is dropped
+int b16_dec_final(b16_dec *s, uint8_t *out, int osize)
+{
+	(void)out, (void)osize;
+	s->half = 0;
+	return 0;
+}
+
+int b16_decode(const char *in, int isize, uint8_t *out, int osize)
+{
+	b16_dec s;
+	int n;
+	b16_dec_init(&s);
+	n = b16_dec_update(&s, in, isize, out, osize);
+	return n + b16_dec_final(&s, out+n, osize-n);
+}
+
+// Decodes buf over itself (e.g. a console line, so it needs no second buffer).  This is safe because each
+// byte is written after the digits it came from are read, at most half way to them.  Returns the number of
+// bytes.
+int b16_decode_inplace(char *buf, int isize)
+{
+	return b16_decode(buf, isize, (uint8_t *)buf, (int)(~0u>>1));
+}
+
+// Renders one hex dump line: [addr " :"] then " XX" per byte (with an extra space every group bytes), then
+// optionally "  " and the bytes as ASCII, and a '\n'.  Short lines are padded to width if there is an ASCII
+// column.  out needs HEXDUMP_LINE_SIZE(width) bytes.  Returns the length of the line.
+int hexdump_line(char *out, uint32_t addr, const uint8_t *data, uint8_t n, uint8_t width, uint8_t group, uint8_t flags)
+{
+	char *o = out;
+	uint8_t i, g, d = flags&HEXDUMP_ADDR_MASK;
+	if (n>width) n = width;
+	if (d>8) d = 8; // All a 32 bit address needs, and all HEXDUMP_LINE_SIZE allows for
+	if (d)
+	{
+		for (i=d; i--; addr>>=4) o[i] = b16_chars[addr&0xF];
+		o += d;
+		*o++ = ' ', *o++ = ':';
+	}
+	for (i=0, g=0; i<width; i++, g++)
+	{
+		if (group && g==group) *o++ = ' ', g = 0;
+		if (i<n) *o++ = ' ', *o++ = b16_chars[data[i]>>4], *o++ = b16_chars[data[i]&0xF];
+		else if (flags&HEXDUMP_ASCII) *o++ = ' ', *o++ = ' ', *o++ = ' ';
+		else break;
+	}
+	if (flags&HEXDUMP_ASCII)
+	{
+		*o++ = ' ', *o++ = ' ';
+		for (i=0; i<n; i++) *o++ = (data[i]>=0x20 && data[i]<0x7F ? data[i] : '.');
+	}
+	*o++ = '\n';
+	*o = 0;
+	return o-out;
+}
+
 int b64_encode_size(int isize, int linewidth)
 {
 	int n = 4*((isize+2)/3);
@@ -51,60 +210,418 @@ int b64_encode_size(int isize, int linewidth)
 	return n;
 }
 
+void b64_enc_init(b64_enc *s, int linewidth)
+{
+	s->linewidth = linewidth, s->w = 0, s->k = 0;
+}
+
+// The k chars of q to out[n], as far as they fit, with a '\n' each time the line position w reaches linewidth
+// (if linewidth>0).  Returns the new n.
+static int coding_put(const char *q, uint8_t k, char *out, int n, int osize, int linewidth, int *w)
+{
+	uint8_t i;
+	if (osize-n>=k && (linewidth<=0 || *w+k<linewidth))
+	{
+		for (i=0; i<k; i++) out[n+i] = q[i];
+		*w += k;
+		return n+k;
+	}
+	// The group reaches the end of a line or of out
+	for (i=0; i<k && n<osize; i++)
+	{
+		out[n++] = q[i];
+		if (linewidth>0 && ++*w>=linewidth && n<osize) out[n++]='\n', *w=0;
+	}
+	return n;
+}
+
+// The four chars of a group to out[n]
+static int b64_enc_put(b64_enc *s, uint8_t a, uint8_t b, uint8_t c, char *out, int n, int osize)
+{
+	char q[4];
+	q[0] = b64_chars[a>>2];
+	q[1] = b64_chars[(a<<4 | b>>4)&0x3F];
+	q[2] = b64_chars[(b<<2 | c>>6)&0x3F];
+	q[3] = b64_chars[c&0x3F];
+	if (s->k)
+	{
+		// The last, partial group, with '=' padding
+		q[3] = '=';
+		if (s->k==1) q[2] = '=';
+	}
+	return coding_put(q, 4, out, n, osize, s->linewidth, &s->w);
+}
+
+// Three bytes to four chars at a time, and a '\n' after each linewidth chars (if linewidth>0).  Up to two
+// bytes are kept for the next update or final.  Returns the number of chars.
+int b64_enc_update(b64_enc *s, const uint8_t *in, int isize, char *out, int osize)
+{
+	int n=0;
+	// Finish a group started by the last update
+	while (s->k && s->k<3 && isize>0) s->p[s->k++] = *in++, isize--;
+	if (s->k==3) s->k = 0, n = b64_enc_put(s, s->p[0], s->p[1], s->p[2], out, n, osize);
+#ifdef LILLIB_CFG_CODING_X86_SIMD
+	n += b64_encode_x86(&in, &isize, (uint8_t *)out+n, osize-n, s->linewidth, &s->w);
+#endif
+	for ( ; isize>=3 && n<osize; in+=3, isize-=3) n = b64_enc_put(s, in[0], in[1], in[2], out, n, osize);
+	if (n>=osize) isize = 0;
+	while (isize-->0) s->p[s->k++] = *in++;
+	return n;
+}
+
+// The partial last group, with '=' padding, and NUL terminates if there is room
+int b64_enc_final(b64_enc *s, char *out, int osize)
+{
+	int n = 0;
+	if (s->k) n = b64_enc_put(s, s->p[0], (s->k>1 ? s->p[1] : 0), 0, out, n, osize), s->k = 0;
+	if (n<osize) out[n] = 0;
+	return n;
+}
+
 int b64_encode(const char *in, int isize, uint8_t *out, int osize, int linewidth)
 {
-	int n=0, w=0;
-	uint8_t b=0;
-	uint8_t pad = (isize%3 ? 3-isize%3 : 0);
-	uint32_t v=0;
-	while (n<osize && isize--)
+	b64_enc s;
+	int n;
+	b64_enc_init(&s, linewidth);
+	n = b64_enc_update(&s, (const uint8_t *)in, isize, (char *)out, osize);
+	return n + b64_enc_final(&s, (char *)out+n, osize-n);
+}
+
+void b64_dec_init(b64_dec *s)
+{
+	s->k = 0, s->done = 0;
+}
+
+// isize<0 (a NUL terminated in) as a length for b64_dec_run
+static int b64_dec_isize(const char *in, int isize)
+{
+	if (isize>=0) return isize;
+#ifdef LILLIB_CFG_CODING_X86_SIMD
+	// The vector code reads whole blocks, so needs to know where in ends
+	return qstrlen(in);
+#else
+	(void)in;
+	return (int)(~0u>>1);
+#endif
+}
+
+// b64_dec_update, moving *in and *isize past the chars it reads, so it can stop when out is full and carry
+// on from there (as the fused stage in coding_aes.c does).  *isize<0 is made a length on the first call.
+int b64_dec_run(b64_dec *st, const char **pin, int *pisize, uint8_t *out, int osize)
+{
+	int n=0, isize=*pisize=b64_dec_isize(*pin, *pisize);
+	const char *in=*pin;
+	uint8_t a, b, c, d, t, k=st->k, *s=st->v;
+#ifdef LILLIB_CFG_CODING_X86_SIMD
+	// The vector code starts on the first group, and again after each whitespace char (so at each new line)
+	uint8_t simd = 1;
+#endif
+	if (st->done) return 0;
+	while (n<osize && isize)
 	{
-		v = (v<<8)|((uint8_t)(*in++)), b+=8;
-		while (b>=6 && n<osize)
+#ifdef LILLIB_CFG_CODING_X86_SIMD
+		if (simd && !k)
+		{
+			n += b64_decode_x86((const uint8_t **)&in, &isize, out+n, osize-n);
+			simd = 0;
+			continue;
+		}
+#endif
+		// Whole groups while there are four chars together, then one char at a time around anything else
+		if (!k && isize>=4 && osize-n>=3 && (a=b64_value(in[0]))<64 && (b=b64_value(in[1]))<64 &&
+			(c=b64_value(in[2]))<64 && (d=b64_value(in[3]))<64)
+		{
+			out[n] = a<<2 | b>>4, out[n+1] = b<<4 | c>>2, out[n+2] = c<<6 | d;
+			in += 4, isize -= 4, n += 3;
+			continue;
+		}
+		t = b64_value(*in++), isize--;
+		if (t==CODING_SKIP)
 		{
-			out[n++] = b64_chars[(v>>(b-=6))&0x3F];
-			if (linewidth>0 && ++w>=linewidth && n<osize) out[n++]='\n', w=0;
+#ifdef LILLIB_CFG_CODING_X86_SIMD
+			simd = 1;
+#endif
+			continue;
+		}
+		if (t>CODING_SKIP) { st->done = 1; break; }
+		s[k++] = t;
+		if (k==4)
+		{
+			out[n++] = s[0]<<2 | s[1]>>4;
+			if (n<osize) out[n++] = s[1]<<4 | s[2]>>2;
+			if (n<osize) out[n++] = s[2]<<6 | s[3];
+			k = 0;
 		}
 	}
-	if (b && n<osize)
+	st->k = k;
+	*pin = in, *pisize = isize;
+	return n;
+}
+
+// Base64 to bytes, skipping whitespace, up to the first '=' or other char (after which done is set and the
+// rest of the input is ignored), or isize chars (isize<0 for all of a NUL terminated in).  Up to three chars
+// of a group are kept for the next update or final.  Returns the number of bytes.
+int b64_dec_update(b64_dec *st, const char *in, int isize, uint8_t *out, int osize)
+{
+	return b64_dec_run(st, &in, &isize, out, osize);
+}
+
+// The whole bytes of a partial last group
+int b64_dec_final(b64_dec *s, uint8_t *out, int osize)
+{
+	int n=0;
+	if (s->k>=2 && n<osize) out[n++] = s->v[0]<<2 | s->v[1]>>4;
+	if (s->k==3 && n<osize) out[n++] = s->v[1]<<4 | s->v[2]>>2;
+	s->k = 0;
+	return n;
+}
+
+int b64_decode(const uint8_t *in, int isize, char *out, int osize)
+{
+	b64_dec s;
+	int n;
+	b64_dec_init(&s);
+	n = b64_dec_update(&s, (const char *)in, isize, (uint8_t *)out, osize);
+	return n + b64_dec_final(&s, (uint8_t *)out+n, osize-n);
+}
+
+// As b16_decode_inplace: the output stays at least a quarter behind the chars it came from, which are all
+// read before it is written, group by group (a block at a time in the vector code, whose stores stop at the
+// block's bytes).
+int b64_decode_inplace(char *buf, int isize)
+{
+	return b64_decode((const uint8_t *)buf, isize, buf, (int)(~0u>>1));
+}
+
+// Z85 (ZeroMQ's base85): each 4 bytes, as a big endian number, to 5 base 85 digits, most significant first.
+// A partial last group of n bytes gives n+1 chars, as Ascii85 does it (the standard only has whole groups):
+// encoded as if padded with zeros, and decoded as if padded with the last digit.
+int z85_encode_size(int isize, int linewidth)
+{
+	int n = isize/4*5 + (isize%4 ? isize%4+1 : 0);
+	if (linewidth>0) n += n / linewidth;
+	return n;
+}
+
+void z85_enc_init(z85_enc *s, int linewidth)
+{
+	s->linewidth = linewidth, s->w = 0, s->k = 0;
+}
+
+#ifdef __AVR__
+static const uint32_t z85_pow[4] PROGMEM = { 85ul*85*85*85, 85ul*85*85, 85ul*85, 85ul };
+#endif
+
+// The first k chars of the group for 4 bytes to out[n]
+static int z85_enc_put(z85_enc *s, const uint8_t *p, uint8_t k, char *out, int n, int osize)
+{
+	uint32_t v = (uint32_t)p[0]<<24 | (uint32_t)p[1]<<16 | (uint16_t)p[2]<<8 | p[3];
+	uint8_t i;
+	char q[5];
+#ifdef __AVR__
+	// There's no divider, and the library's 32 bit division is slow, so each digit (<128) is found a bit at
+	// a time by shift and subtract
+	uint32_t d;
+	uint8_t b, t;
+	for (i=0; i<4; i++)
 	{
-		out[n++] = b64_chars[(v<<(6-b))&0x3F];
-		if (linewidth>0 && ++w>=linewidth && n<osize) out[n++]='\n', w=0;
+		d = pgm_read_dword(&z85_pow[i])<<6;
+		for (t=0, b=0x40; b; b>>=1, d>>=1) if (v>=d) v -= d, t |= b;
+		q[i] = pgm_read_byte(&z85_chars[t]);
 	}
-	while (pad-- && n<osize)
+	q[4] = pgm_read_byte(&z85_chars[v]);
+#else
+	for (i=5; i--; v/=85) q[i] = pgm_read_byte(&z85_chars[v%85]);
+#endif
+	return coding_put(q, k, out, n, osize, s->linewidth, &s->w);
+}
+
+// Four bytes to five chars at a time, and a '\n' after each linewidth chars (if linewidth>0).  Up to three
+// bytes are kept for the next update or final.  Returns the number of chars.
+int z85_enc_update(z85_enc *s, const uint8_t *in, int isize, char *out, int osize)
+{
+	int n=0;
+	// Finish a group started by the last update
+	while (s->k && s->k<4 && isize>0) s->p[s->k++] = *in++, isize--;
+	if (s->k==4) s->k = 0, n = z85_enc_put(s, s->p, 5, out, n, osize);
+	for ( ; isize>=4 && n<osize; in+=4, isize-=4) n = z85_enc_put(s, in, 5, out, n, osize);
+	if (n>=osize) isize = 0;
+	while (isize-->0) s->p[s->k++] = *in++;
+	return n;
+}
+
+// The partial last group, and NUL terminates if there is room
+int z85_enc_final(z85_enc *s, char *out, int osize)
+{
+	int n = 0;
+	if (s->k)
 	{
-		out[n++] = '=';
-		if (linewidth>0 && ++w>=linewidth && n<osize) out[n++]='\n', w=0;
+		qmemset(s->p+s->k, 0, 4-s->k);
+		n = z85_enc_put(s, s->p, s->k+1, out, n, osize);
+		s->k = 0;
 	}
 	if (n<osize) out[n] = 0;
 	return n;
 }
 
-int b64_decode(const uint8_t *in, int isize, char *out, int osize)
+int z85_encode(const uint8_t *in, int isize, char *out, int osize, int linewidth)
+{
+	z85_enc s;
+	int n;
+	z85_enc_init(&s, linewidth);
+	n = z85_enc_update(&s, in, isize, out, osize);
+	return n + z85_enc_final(&s, out+n, osize-n);
+}
+
+void z85_dec_init(z85_dec *s)
+{
+	s->v = 0, s->k = 0, s->done = 0;
+}
+
+// Up to k of the bytes of v to out[n].  Returns the new n.
+static int z85_dec_put(uint32_t v, uint8_t k, uint8_t *out, int n, int osize)
+{
+	uint8_t i;
+	for (i=0; i<k && n<osize; i++, v<<=8) out[n++] = v>>24;
+	return n;
+}
+
+// Z85 to bytes, skipping whitespace, up to the first other char or a group too big for 32 bits (which is
+// dropped).  After either, done is set and the rest of the input is ignored.  Stops after isize chars (isize<0
+// for all of a NUL terminated in).  Up to four chars of a group are kept for the next update or final.
+// Returns the number of bytes.
+int z85_dec_update(z85_dec *s, const char *in, int isize, uint8_t *out, int osize)
 {
-	char c;
 	int n=0;
-	uint8_t b=0, t;
-	uint32_t v=0;
-	while ((c=*in++)!=0 && n<osize && isize--)
+	uint32_t v=s->v;
+	uint8_t t, k=s->k;
+	if (s->done) return 0;
+	if (isize<0) isize = (int)(~0u>>1);
+	while (n<osize && isize--)
 	{
-		if      (c>='A' && c<='Z') t = c-'A';
-		else if (c>='a' && c<='z') t = c-'a'+26;
-		else if (c>='0' && c<='9') t = c-'0'+52;
-		else if (c=='+') t = 62;
-		else if (c=='/') t = 63;
-		else if (c=='=') break;
-		else if (isspace((uint8_t)c)) continue;
-		else break;
-		b += 6;
-		v = (v<<6)|t;
-		if (b>=8)
+		t = z85_value(*in++);
+		if (t==CODING_SKIP) continue;
+		if (t>CODING_SKIP) { s->done = 1; break; }
+		if (k==4)
+		{
+			// 0xFFFFFFFF is 85*0x03030303 exactly
+			if (v>0x03030303 || (v==0x03030303 && t)) { s->done = 1, k = 0; break; }
+			n = z85_dec_put(v*85+t, 4, out, n, osize);
+			v = 0, k = 0;
+			continue;
+		}
+		v = v*85+t, k++;
+	}
+	s->v = v, s->k = k;
+	return n;
+}
+
+// The whole bytes of a partial last group (a lone char has none).  As in z85_dec_update, a group too big
+// for 32 bits (which no encoder makes) is dropped and sets done.
+int z85_dec_final(z85_dec *s, uint8_t *out, int osize)
+{
+	int n=0;
+	uint8_t i;
+	if (s->k>=2)
+	{
+		for (i=s->k; i<4; i++) s->v = s->v*85+84;
+		if (s->v>=0x03030303) s->done = 1;
+		else n = z85_dec_put(s->v*85+84, s->k-1, out, n, osize);
+	}
+	s->v = 0, s->k = 0;
+	return n;
+}
+
+int z85_decode(const char *in, int isize, uint8_t *out, int osize)
+{
+	z85_dec s;
+	int n;
+	z85_dec_init(&s);
+	n = z85_dec_update(&s, in, isize, out, osize);
+	return n + z85_dec_final(&s, out+n, osize-n);
+}
+
+// COBS framing: each run of up to 254 non-zero bytes is sent after a code byte of its length+1, and a run
+// shorter than 254 stands for the run and the zero after it (bar the last), so frames have no zero bytes
+// and can be delimited by one.  The delimiter isn't part of the encoding here.
+int cobs_encode_size(int isize)
+{
+	return isize + isize/254 + 1;
+}
+
+// Returns the length of the encoding, or -1 if out is too small (it needs cobs_encode_size(isize))
+int cobs_encode(const uint8_t *in, int isize, uint8_t *out, int osize)
+{
+	int n=0;
+	uint8_t k;
+	const uint8_t *z;
+	while (1)
+	{
+		k = (isize<254 ? isize : 254);
+		if ((z=qmemchr(in, 0, k))) k = z-in;
+		if (osize-n<k+1) return -1;
+		out[n++] = k+1;
+		qmemcpy(out+n, in, k);
+		n += k, in += k, isize -= k;
+		if (!isize) break;
+		if (k<254) in++, isize--; // The zero the run stands for
+	}
+	return n;
+}
+
+void cobs_dec_init(cobs_dec *s)
+{
+	s->left = 0, s->zero = 0, s->done = 0, s->error = 0;
+}
+
+// Decodes a frame up to and including its 0 delimiter (after which done is set and the rest of the input is
+// ignored).  A frame that ends inside a run, or doesn't fit in what is left of out over all the updates, sets
+// error (but is still read to its end, so the next one starts in the right place).  Returns the number of
+// bytes.
+int cobs_dec_update(cobs_dec *s, const uint8_t *in, int isize, uint8_t *out, int osize)
+{
+	int n=0, m;
+	uint8_t c, k;
+	const uint8_t *z;
+	if (s->done) return 0;
+	while (isize>0)
+	{
+		if (s->left && *in)
+		{
+			// The bytes of the run, up to any 0 in it (which ends the frame early)
+			k = (isize<s->left ? isize : s->left);
+			if ((z=qmemchr(in, 0, k))) k = z-in;
+			m = (osize-n<k ? osize-n : k);
+			qmemcpy(out+n, in, m), n += m;
+			if (m<k) s->error = 1;
+			in += k, isize -= k, s->left -= k;
+			continue;
+		}
+		c = *in++, isize--;
+		if (!c)
+		{
+			s->done = 1;
+			if (s->left) s->error = 1;
+			break;
+		}
+		// A code byte, which puts out the zero after the last run
+		if (s->zero)
 		{
-			b-=8;
-			*out++ = (uint8_t)(v>>b);
-			n++;
+			if (n<osize) out[n++] = 0;
+			else s->error = 1;
 		}
+		s->left = c-1, s->zero = (c<0xFF);
 	}
 	return n;
 }
 
+// Decodes the frame at the start of in, which ends at a 0 or after isize bytes.  Returns its length, or -1 if
+// it's malformed or too long for out.
+int cobs_decode(const uint8_t *in, int isize, uint8_t *out, int osize)
+{
+	cobs_dec s;
+	int n;
+	cobs_dec_init(&s);
+	n = cobs_dec_update(&s, in, isize, out, osize);
+	return (s.error || s.left ? -1 : n);
+}
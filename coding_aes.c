@@ -0,0 +1,48 @@
+#include "lillib.h"
+#ifdef LILLIB_AES_CTR
+// Base64 to AES-128 CTR decryption in one pass: the bytes are decoded straight into a block, which is
+// decrypted when full and handed to sink, so there is no buffer for the whole message.  The block has two
+// spare bytes, as the decoder writes whole groups of three, and those go to the front of the next one.
+// key is as aes128_ctr takes it (see aes128_ctr_key), and must stay valid while the stage is used.  This
+// is kept out of coding.c so the codecs can be linked without aes.c.
+void b64_ctr_dec_init(b64_ctr_dec *s, const uint8_t *key, const uint8_t ctr[16], aes_ctr_sink sink)
+{
+	b64_dec_init(&s->b64);
+	qmemcpy(s->ctr, ctr, 16);
+	s->key = key, s->sink = sink, s->k = 0;
+}
+
+// Decrypts the block and hands its first n bytes to sink, moving any spare bytes to the front
+static uint8_t b64_ctr_dec_block(b64_ctr_dec *s, uint8_t n)
+{
+	aes128_ctr(s->key, s->ctr, s->block, 1);
+	s->sink(s->block, n);
+	s->k -= n;
+	s->block[0] = s->block[16], s->block[1] = s->block[17];
+	return n;
+}
+
+// Returns the number of bytes handed to sink
+int b64_ctr_dec_update(b64_ctr_dec *s, const char *in, int isize)
+{
+	int n=0;
+	uint8_t room;
+	while (isize && !s->b64.done)
+	{
+		room = 16-s->k;
+		s->k += b64_dec_run(&s->b64, &in, &isize, s->block+s->k, room+(3-room%3)%3);
+		if (s->k>=16) n += b64_ctr_dec_block(s, 16);
+	}
+	return n;
+}
+
+// The partial last group, and what is left of the block
+int b64_ctr_dec_final(b64_ctr_dec *s)
+{
+	int n=0;
+	s->k += b64_dec_final(&s->b64, s->block+s->k, sizeof(s->block)-s->k);
+	if (s->k>=16) n += b64_ctr_dec_block(s, 16);
+	if (s->k) n += b64_ctr_dec_block(s, s->k);
+	return n;
+}
+#endif // LILLIB_AES_CTR
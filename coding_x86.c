@@ -0,0 +1,245 @@
+#include "lillib.h"
+#if defined(__x86_64__) && defined(LILLIB_CFG_CODING_X86_SIMD)
+
+// SSSE3 and AVX2 base64 for hosts, picked at run time.  These only do the bulk of the data, 12 or 24 bytes
+// (16 or 32 chars) at a time, and b64_encode/b64_decode do the rest and anything unusual, so the output is
+// exactly theirs: b64_decode_x86 stops at the first block that isn't all base64 chars (so at whitespace,
+// '=', the end, or an error), and b64_encode_x86 puts in the same '\n's as it goes.
+// The char<->value translation and the bit packing are as in Wojciech Muła's and Alfred Klomp's base64
+// work: pshufb lookups on the high and low nibbles of each char, and multiplies to move the bit fields.
+#include <immintrin.h>
+
+// 0 for plain C, 1 for SSSE3, 2 for AVX2.  0xFF until the first call sets it from the CPU, and it can be
+// lowered to force a slower path (the tests and benchmarks do).
+uint8_t b64_x86_level = 0xFF;
+
+static uint8_t b64_x86_get_level(void)
+{
+	if (b64_x86_level==0xFF)
+	{
+		__builtin_cpu_init();
+		b64_x86_level = (__builtin_cpu_supports("avx2") ? 2 : __builtin_cpu_supports("ssse3") ? 1 : 0);
+	}
+	return b64_x86_level;
+}
+
+// Copies the k chars of a block to out, with a '\n' each time w reaches linewidth.  Returns the new n.
+static int b64_x86_put(uint8_t *out, int n, const uint8_t *chars, int k, int linewidth, int *w)
+{
+	int m;
+	while (k)
+	{
+		m = linewidth - *w;
+		if (m>k) m = k;
+		__builtin_memcpy(out+n, chars, m);
+		n += m, chars += m, k -= m, *w += m;
+		if (*w>=linewidth) out[n++] = '\n', *w = 0;
+	}
+	return n;
+}
+
+__attribute__((target("ssse3")))
+static __m128i b64_x86_enc_128(__m128i x)
+{
+	// Values to chars: 0-25 get 'A', 26-51 'a'-26, 52-61 '0'-52 and 62/63 their own offsets, picked by a
+	// pshufb on an index of 13 for 0-25, 0 for 26-51, and 1-12 for 52-63
+	const __m128i offsets = _mm_setr_epi8('a'-26, '0'-52, '0'-52, '0'-52, '0'-52, '0'-52, '0'-52, '0'-52,
+	                                      '0'-52, '0'-52, '0'-52, '+'-62, '/'-63, 'A', 0, 0);
+	__m128i i;
+	// 12 bytes (the first 3 of each 4) to 16 values of 6 bits.  Each 4 bytes become b a c b, and the
+	// multiplies shift the four fields into place.
+	x = _mm_shuffle_epi8(x, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+	x = _mm_or_si128(_mm_mulhi_epu16(_mm_and_si128(x, _mm_set1_epi32(0x0FC0FC00)), _mm_set1_epi32(0x04000040)),
+	                 _mm_mullo_epi16(_mm_and_si128(x, _mm_set1_epi32(0x003F03F0)), _mm_set1_epi32(0x01000010)));
+	i = _mm_subs_epu8(x, _mm_set1_epi8(51));
+	i = _mm_or_si128(i, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), x), _mm_set1_epi8(13)));
+	return _mm_add_epi8(x, _mm_shuffle_epi8(offsets, i));
+}
+
+__attribute__((target("avx2")))
+static __m256i b64_x86_enc_256(__m256i x)
+{
+	const __m256i offsets = _mm256_setr_epi8('a'-26, '0'-52, '0'-52, '0'-52, '0'-52, '0'-52, '0'-52, '0'-52,
+	                                         '0'-52, '0'-52, '0'-52, '+'-62, '/'-63, 'A', 0, 0,
+	                                         'a'-26, '0'-52, '0'-52, '0'-52, '0'-52, '0'-52, '0'-52, '0'-52,
+	                                         '0'-52, '0'-52, '0'-52, '+'-62, '/'-63, 'A', 0, 0);
+	__m256i i;
+	x = _mm256_shuffle_epi8(x, _mm256_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+	                                           10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+	x = _mm256_or_si256(_mm256_mulhi_epu16(_mm256_and_si256(x, _mm256_set1_epi32(0x0FC0FC00)), _mm256_set1_epi32(0x04000040)),
+	                    _mm256_mullo_epi16(_mm256_and_si256(x, _mm256_set1_epi32(0x003F03F0)), _mm256_set1_epi32(0x01000010)));
+	i = _mm256_subs_epu8(x, _mm256_set1_epi8(51));
+	i = _mm256_or_si256(i, _mm256_and_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(26), x), _mm256_set1_epi8(13)));
+	return _mm256_add_epi8(x, _mm256_shuffle_epi8(offsets, i));
+}
+
+// Chars to values, or returns 0 if any isn't a base64 char.  The high nibble and low nibble lookups each
+// give a set of classes, which only intersect for valid chars, and the high nibble (or 1 for '/') picks
+// the offset to the value.
+__attribute__((target("ssse3")))
+static int b64_x86_dec_128(__m128i *x)
+{
+	const __m128i lut_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+	                                     0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+	const __m128i lut_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+	                                     0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+	const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+	const __m128i mask = _mm_set1_epi8(0x2F); // pshufb only looks at the low nibble (and bit 7)
+	__m128i hi_nibbles = _mm_and_si128(_mm_srli_epi32(*x, 4), mask);
+	__m128i lo = _mm_shuffle_epi8(lut_lo, _mm_and_si128(*x, mask));
+	__m128i hi = _mm_shuffle_epi8(lut_hi, hi_nibbles);
+	if (_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128()))) return 0;
+	*x = _mm_add_epi8(*x, _mm_shuffle_epi8(lut_roll, _mm_add_epi8(_mm_cmpeq_epi8(*x, mask), hi_nibbles)));
+	// Pack each 4 values to 3 bytes, in the low 12 bytes
+	*x = _mm_madd_epi16(_mm_maddubs_epi16(*x, _mm_set1_epi32(0x01400140)), _mm_set1_epi32(0x00011000));
+	*x = _mm_shuffle_epi8(*x, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+	return 1;
+}
+
+__attribute__((target("avx2")))
+static int b64_x86_dec_256(__m256i *x)
+{
+	const __m256i lut_lo = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+	                                        0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+	                                        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+	                                        0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+	const __m256i lut_hi = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+	                                        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+	                                        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+	                                        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+	const __m256i lut_roll = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+	                                          0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+	const __m256i mask = _mm256_set1_epi8(0x2F);
+	__m256i hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(*x, 4), mask);
+	__m256i lo = _mm256_shuffle_epi8(lut_lo, _mm256_and_si256(*x, mask));
+	__m256i hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+	if (!_mm256_testz_si256(lo, hi)) return 0;
+	*x = _mm256_add_epi8(*x, _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(_mm256_cmpeq_epi8(*x, mask), hi_nibbles)));
+	// 12 bytes in the low end of each lane, then the lanes together in the low 24
+	*x = _mm256_madd_epi16(_mm256_maddubs_epi16(*x, _mm256_set1_epi32(0x01400140)), _mm256_set1_epi32(0x00011000));
+	*x = _mm256_shuffle_epi8(*x, _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+	                                              2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+	*x = _mm256_permutevar8x32_epi32(*x, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+	return 1;
+}
+
+// The encoders read a whole 16 or 32 byte register (so a bit past the 12 or 24 bytes they use) and write
+// one (with room for a '\n' per char), so they stop while there's still plenty left for the C code.  The
+// decoders write just the bytes they decode, so never past the output so far.
+__attribute__((target("avx2")))
+static int b64_x86_encode_avx2(const uint8_t **in, int *isize, uint8_t *out, int osize, int linewidth, int *w)
+{
+	const uint8_t *s = *in;
+	int n = 0;
+	uint8_t tmp[32];
+	__m256i x;
+	for ( ; *isize>=28 && osize-n>=64; s+=24, *isize-=24)
+	{
+		x = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)s)),
+		                            _mm_loadu_si128((const __m128i *)(s+12)), 1);
+		x = b64_x86_enc_256(x);
+		if (linewidth<=0 || *w+32<linewidth)
+		{
+			_mm256_storeu_si256((__m256i *)(out+n), x);
+			n += 32, *w += 32;
+		}
+		else
+		{
+			_mm256_storeu_si256((__m256i *)tmp, x);
+			n = b64_x86_put(out, n, tmp, 32, linewidth, w);
+		}
+	}
+	*in = s;
+	return n;
+}
+
+__attribute__((target("ssse3")))
+static int b64_x86_encode_ssse3(const uint8_t **in, int *isize, uint8_t *out, int osize, int linewidth, int *w)
+{
+	const uint8_t *s = *in;
+	int n = 0;
+	uint8_t tmp[16];
+	__m128i x;
+	for ( ; *isize>=16 && osize-n>=32; s+=12, *isize-=12)
+	{
+		x = b64_x86_enc_128(_mm_loadu_si128((const __m128i *)s));
+		if (linewidth<=0 || *w+16<linewidth)
+		{
+			_mm_storeu_si128((__m128i *)(out+n), x);
+			n += 16, *w += 16;
+		}
+		else
+		{
+			_mm_storeu_si128((__m128i *)tmp, x);
+			n = b64_x86_put(out, n, tmp, 16, linewidth, w);
+		}
+	}
+	*in = s;
+	return n;
+}
+
+// Encodes whole blocks from *in, advancing it and reducing *isize, and updating the line position *w.
+// Returns the number of chars.
+int b64_encode_x86(const uint8_t **in, int *isize, uint8_t *out, int osize, int linewidth, int *w)
+{
+	switch (b64_x86_get_level())
+	{
+	case 2: return b64_x86_encode_avx2(in, isize, out, osize, linewidth, w);
+	case 1: return b64_x86_encode_ssse3(in, isize, out, osize, linewidth, w);
+	default: return 0;
+	}
+}
+
+__attribute__((target("avx2")))
+static int b64_x86_decode_avx2(const uint8_t **in, int *isize, uint8_t *out, int osize)
+{
+	const uint8_t *s = *in;
+	int n = 0;
+	__m256i x;
+	for ( ; *isize>=32 && osize-n>=24; s+=32, *isize-=32, n+=24)
+	{
+		x = _mm256_loadu_si256((const __m256i *)s);
+		if (!b64_x86_dec_256(&x)) break;
+		_mm_storeu_si128((__m128i *)(out+n), _mm256_castsi256_si128(x));
+		_mm_storel_epi64((__m128i *)(out+n+16), _mm256_extracti128_si256(x, 1));
+	}
+	*in = s;
+	return n;
+}
+
+__attribute__((target("ssse3")))
+static int b64_x86_decode_ssse3(const uint8_t **in, int *isize, uint8_t *out, int osize)
+{
+	const uint8_t *s = *in;
+	int n = 0;
+	__m128i x;
+	uint32_t t;
+	for ( ; *isize>=16 && osize-n>=12; s+=16, *isize-=16, n+=12)
+	{
+		x = _mm_loadu_si128((const __m128i *)s);
+		if (!b64_x86_dec_128(&x)) break;
+		_mm_storel_epi64((__m128i *)(out+n), x);
+		t = _mm_cvtsi128_si32(_mm_srli_si128(x, 8));
+		__builtin_memcpy(out+n+8, &t, 4);
+	}
+	*in = s;
+	return n;
+}
+
+// Decodes whole blocks of base64 chars from *in, advancing it and reducing *isize.  Returns the number of
+// bytes, and stops at the first block with anything else in it.
+int b64_decode_x86(const uint8_t **in, int *isize, uint8_t *out, int osize)
+{
+	int n;
+	switch (b64_x86_get_level())
+	{
+	case 2:
+		// The last few blocks (or any after a line break) can still go 16 at a time
+		n = b64_x86_decode_avx2(in, isize, out, osize);
+		return n + b64_x86_decode_ssse3(in, isize, out+n, osize-n);
+	case 1: return b64_x86_decode_ssse3(in, isize, out, osize);
+	default: return 0;
+	}
+}
+
+#endif
@@ -9,7 +9,14 @@ void com_puts(const char *str)
 	com_putc('\n');
 }
 
-void com_printf(const char *fmt, ...)
+// Bulk write, overridden by devices that can do better than a com_putc per char
+void __attribute__((weak)) com_write(const char *data, int n)
+{
+	while (n-- > 0) com_putc(*data++);
+}
+
+// Devices with a TX ring override these to format straight into it (see strf_print_bulk)
+void __attribute__((weak)) com_printf(const char *fmt, ...)
 {
 	va_list args;
 	va_start(args, fmt);
@@ -17,19 +24,73 @@ void com_printf(const char *fmt, ...)
 	va_end(args);
 }
 
+void com_puts_P(const char *str)
+{
+	char c;
+	while ((c=pgm_read_byte(str++))) com_putc(c);
+	com_putc('\n');
+}
+
+void __attribute__((weak)) com_printf_P(const char *fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	strf_print_P(com_putc, fmt, args);
+	va_end(args);
+}
+
 void com_print_buf(const char *title, uint8_t *buf, int n, int wrap)
 {
-	int i,w;
+	char line[HEXDUMP_LINE_SIZE(LILLIB_CFG_HEXDUMP_MAX_WIDTH)];
+	uint8_t d = 3;
+	int k;
 	com_printf("%s :", title);
-	if (wrap>0) com_putc('\n');
-	for (i=0,w=wrap; i<n; i++)
+	if (wrap>0)
+	{
+		while (d<8 && ((uint32_t)n-1)>>(4*d)) d++;
+		com_putc('\n');
+		com_hexdump(0, buf, n, wrap, 0, HEXDUMP_ADDR(d));
+		return;
+	}
+	// All on the one line
+	for ( ; n>0; n-=k, buf+=k)
 	{
-		if (--w==0) com_printf("\n%03X :", i), w=wrap;
-		com_printf(" %02X", buf[i]);
+		k = (n<LILLIB_CFG_HEXDUMP_MAX_WIDTH ? n : LILLIB_CFG_HEXDUMP_MAX_WIDTH);
+		com_write(line, hexdump_line(line, 0, buf, k, k, 0, 0)-1);
 	}
 	com_putc('\n');
 }
 
+// Hex dumps data as lines of width bytes (see hexdump_line), addr being the address of data[0]
+void com_hexdump(uint32_t addr, const uint8_t *data, int n, uint8_t width, uint8_t group, uint8_t flags)
+{
+	char line[HEXDUMP_LINE_SIZE(LILLIB_CFG_HEXDUMP_MAX_WIDTH)];
+	uint8_t k;
+	if (width>LILLIB_CFG_HEXDUMP_MAX_WIDTH) width = LILLIB_CFG_HEXDUMP_MAX_WIDTH;
+	if (!width) width = 1;
+	for ( ; n>0; n-=k, data+=k, addr+=k)
+	{
+		k = (n<width ? n : width);
+		com_write(line, hexdump_line(line, addr, data, k, width, group, flags));
+	}
+}
+
+// As com_hexdump, for data that isn't in RAM (e.g. EEPROM or external flash), read a line at a time
+void com_hexdump_stream(uint32_t addr, uint32_t n, hexdump_read read, uint8_t width, uint8_t group, uint8_t flags)
+{
+	char line[HEXDUMP_LINE_SIZE(LILLIB_CFG_HEXDUMP_MAX_WIDTH)];
+	uint8_t data[LILLIB_CFG_HEXDUMP_MAX_WIDTH];
+	uint8_t k;
+	if (width>LILLIB_CFG_HEXDUMP_MAX_WIDTH) width = LILLIB_CFG_HEXDUMP_MAX_WIDTH;
+	if (!width) width = 1;
+	for ( ; n>0; n-=k, addr+=k)
+	{
+		k = (n<width ? n : width);
+		read(addr, data, k);
+		com_write(line, hexdump_line(line, addr, data, k, width, group, flags));
+	}
+}
+
 char *com_gets(char *buf, uint8_t size, uint8_t echo)
 {
 	char c;
@@ -46,3 +107,47 @@ char *com_gets(char *buf, uint8_t size, uint8_t echo)
 	*str = 0;
 	return (str==buf ? NULL : buf); // If transmission ended with no data, we hit EOF
 }
+
+// 8-bit clean transmission, for devices that otherwise mask what they send to 7 bits.  Anything already
+// queued goes out in the old mode first (the device waits for it).
+void __attribute__((weak)) com_set_binary(uint8_t on)
+{
+	(void)on;
+}
+
+// Sends data as a COBS frame (see coding.c) and its 0 delimiter.  Each run goes straight from data to
+// com_write, so there's no buffer for the encoding.  Needs binary mode: call com_set_binary(1) before it,
+// which waits for queued text to go out masked, and com_set_binary(0) only after it, which waits for the
+// packet to go out unmasked.  Switching in between would mask or unmask bytes still in the TX ring.
+void com_send_packet(const uint8_t *data, int n)
+{
+	uint8_t k;
+	const uint8_t *z;
+	while (1)
+	{
+		k = (n<254 ? n : 254);
+		if ((z=qmemchr(data, 0, k))) k = z-data;
+		com_putc(k+1);
+		com_write((const char *)data, k);
+		data += k, n -= k;
+		if (!n) break;
+		if (k<254) data++, n--;
+	}
+	com_putc(0);
+}
+
+// Receives the next COBS frame into buf, decoding as it goes.  Returns its length, or -1 if it was malformed
+// or longer than size (either way, all of it is read).
+int com_recv_packet(uint8_t *buf, int size)
+{
+	cobs_dec s;
+	uint8_t c;
+	int n = 0;
+	cobs_dec_init(&s);
+	while (!s.done)
+	{
+		c = com_getc();
+		n += cobs_dec_update(&s, &c, 1, buf+n, size-n);
+	}
+	return (s.error ? -1 : n);
+}
@@ -2,10 +2,18 @@
 #include "lillib.h"
 // A return of 0 is considered success.
 
+#ifdef LILLIB_CFG_CONSOLE_PGM_STRINGS
+#define CONSOLE_CMD_LIST_FMT PSTR("  %<16s%S\n")
+#define CONSOLE_CMD_NO_USAGE PSTR("?")
+#else
+#define CONSOLE_CMD_LIST_FMT PSTR("  %<16s%s\n")
+#define CONSOLE_CMD_NO_USAGE "?"
+#endif
+
 // Called to print prompt; may return non-zero to terminate
 char __attribute__((weak)) console_prompt(void *state)
 {
-	com_printf("\n> ");
+	com_printf_P(PSTR("\n> "));
 	return 0;
 }
 
@@ -34,14 +42,15 @@ char __attribute__((weak)) console_readline(char *buf, uint8_t size)
 	return i; // If transmission ended with no data, we hit EOF
 }
 
-static uint8_t arg_split(char *buf, char **argv)
+// Splits up to max args, leaving *rest at the remainder of the line
+static uint8_t arg_split(char *buf, char **argv, uint8_t max, char **rest)
 {
 	uint8_t n = 0;
-	while (n<LILLIB_CFG_CONSOLE_MAX_ARGV)
+	while (1)
 	{
 		//Strip leading spaces
 		while (*buf && isspace((uint8_t)*buf)) buf++;
-		if (!*buf) break;
+		if (!*buf || n>=max) break;
 		//Save text pointer
 		*argv++ = buf;
 		n++;
@@ -51,6 +60,7 @@ static uint8_t arg_split(char *buf, char **argv)
 		//Terminate arg and move to next
 		*buf++ = 0;
 	}
+	*rest = buf;
 	return n;
 }
 
@@ -60,6 +70,7 @@ int console(const _console_cmd *commands, LILLIB_CFG_CONSOLE_STATE_TYPE *state)
 	const _console_cmd *c;
 	char buf[LILLIB_CFG_CONSOLE_LINEBUFSIZE];
 	char *argv[LILLIB_CFG_CONSOLE_MAX_ARGV];
+	char *rest;
 	uint8_t argc;
 	int ret;
 	//Go
@@ -67,14 +78,14 @@ int console(const _console_cmd *commands, LILLIB_CFG_CONSOLE_STATE_TYPE *state)
 	{
 		if ((ret=console_prompt(state))!=0) return ret;
 		if (!console_readline(buf, LILLIB_CFG_CONSOLE_LINEBUFSIZE)) break;
-		argc = arg_split(buf, argv);
+		argc = arg_split(buf, argv, 1, &rest);
 
 		//Print commands on no input
 		if (!argc)
 		{
-			com_puts("Available Commands:");
-			for (c=commands; c->name; c++) com_printf("  %<16s%s\n", c->name, (c->usage ? c->usage : "?"));
-			com_puts("type \"help COMMAND\" for help");
+			com_puts_P(PSTR("Available Commands:"));
+			for (c=commands; c->name; c++) com_printf_P(CONSOLE_CMD_LIST_FMT, c->name, (c->usage ? c->usage : CONSOLE_CMD_NO_USAGE));
+			com_puts_P(PSTR("type \"help COMMAND\" for help"));
 			continue;
 		}
 		/*
@@ -90,11 +101,13 @@ int console(const _console_cmd *commands, LILLIB_CFG_CONSOLE_STATE_TYPE *state)
 		for (c=commands; c->name; c++)
 		{
 			if (qstrcmp(argv[0], c->name)) continue;
+			if (!(c->flags&CONSOLE_CMD_RAW)) argc += arg_split(rest, argv+1, LILLIB_CFG_CONSOLE_MAX_ARGV-1, &rest);
+			else if (*rest) argv[argc++] = rest;
 			ret = c->func(argc, argv, state);
 			if (ret) return ret;
 			break;
 		}
-		if (!c->name) com_puts("Command not found");
+		if (!c->name) com_puts_P(PSTR("Command not found"));
 	}
 	return 0;
 }
@@ -3,55 +3,562 @@
 #include <stdarg.h>
 #include "lillib.h"
 
-void qsprintf(char *buf, int size, const char *fmt, ...)
+int qsprintf(char *buf, int size, const char *fmt, ...)
 {
+	int n;
 	va_list args;
 	va_start(args, fmt);
-	strf_sprint(buf, size, fmt, args);
+	n = strf_sprint(buf, size, fmt, args);
 	va_end(args);
+	return n;
+}
+
+int qsprintf_P(char *buf, int size, const char *fmt, ...)
+{
+	int n;
+	va_list args;
+	va_start(args, fmt);
+	n = strf_sprint_P(buf, size, fmt, args);
+	va_end(args);
+	return n;
+}
+
+#ifdef __AVR__
+// The AVR has no divider, so the generic loop below costs a libgcc division call per digit.
+// Instead, decimal digits are produced by subtracting powers of 10 (at most 9 times each) and, since the
+// digit count is known up front, written forward from their final position.
+#define ITOA2_B10_SUB8(o, v, p)         \
+	__asm__ (                           \
+		"   ldi   %[d], '0'-1       \n" \
+		"1: inc   %[d]              \n" \
+		"   subi  %[v], %[p]        \n" \
+		"   brcc  1b                \n" \
+		"   subi  %[v], lo8(-%[p])  \n" \
+		"   st    %a[o]+, %[d]      \n" \
+		: [v] "+d" (v), [o] "+e" (o), [d] "=&d" (d) \
+		: [p] "n" (p)                   \
+	)
+#define ITOA2_B10_SUB16(o, v, p)        \
+	__asm__ (                           \
+		"   ldi   %[d], '0'-1       \n" \
+		"1: inc   %[d]              \n" \
+		"   subi  %A[v], lo8(%[p])  \n" \
+		"   sbci  %B[v], hi8(%[p])  \n" \
+		"   brcc  1b                \n" \
+		"   subi  %A[v], lo8(-%[p]) \n" \
+		"   sbci  %B[v], hi8(-%[p]) \n" \
+		"   st    %a[o]+, %[d]      \n" \
+		: [v] "+d" (v), [o] "+e" (o), [d] "=&d" (d) \
+		: [p] "n" (p)                   \
+	)
+
+static char *itoa2_b10_u8(char *rbuf, uint8_t v)
+{
+	char *o, *s = rbuf - (v>=100 ? 3 : v>=10 ? 2 : 1);
+	uint8_t d;
+	o = s;
+	switch (rbuf-s)
+	{
+		case 3: ITOA2_B10_SUB8(o, v, 100); // fall through
+		case 2: ITOA2_B10_SUB8(o, v, 10);  // fall through
+		default: *o = '0'+v;
+	}
+	return s;
+}
+
+static char *itoa2_b10_u16(char *rbuf, uint16_t v)
+{
+	char *o, *s;
+	uint8_t d, v8;
+	if (v<256) return itoa2_b10_u8(rbuf, v);
+	s = rbuf - (v>=10000 ? 5 : v>=1000 ? 4 : 3);
+	o = s;
+	switch (rbuf-s)
+	{
+		case 5: ITOA2_B10_SUB16(o, v, 10000); // fall through
+		case 4: ITOA2_B10_SUB16(o, v, 1000);  // fall through
+		default: ITOA2_B10_SUB16(o, v, 100);
+	}
+	v8 = v; // <100 now
+	ITOA2_B10_SUB8(o, v8, 10);
+	*o = '0'+v8;
+	return s;
+}
+
+static char *itoa2_b10_u32(char *rbuf, uint32_t v)
+{
+	// One 32-bit division per 4 digits, which are then done by the 16-bit path
+	char *e;
+	while (v>0xFFFF)
+	{
+		uint16_t lo = v%10000;
+		v = v/10000;
+		e = rbuf-4;
+		rbuf = itoa2_b10_u16(rbuf, lo);
+		while (rbuf>e) *--rbuf = '0';
+	}
+	return itoa2_b10_u16(rbuf, v);
+}
+#else
+// With a hardware divider the cost is the chain of dependent divides, so halve it by producing two
+// digits per step from a "00".."99" table.
+static const char itoa2_b10_pairs[200] =
+	"00010203040506070809101112131415161718192021222324"
+	"25262728293031323334353637383940414243444546474849"
+	"50515253545556575859606162636465666768697071727374"
+	"75767778798081828384858687888990919293949596979899";
+
+static char *itoa2_b10_u32(char *rbuf, uint32_t v)
+{
+	uint32_t i;
+	while (v>=100)
+	{
+		i = (v%100)*2;
+		v = v/100;
+		*--rbuf = itoa2_b10_pairs[i+1];
+		*--rbuf = itoa2_b10_pairs[i];
+	}
+	if (v<10) *--rbuf = '0'+v;
+	else      *--rbuf = itoa2_b10_pairs[2*v+1], *--rbuf = itoa2_b10_pairs[2*v];
+	return rbuf;
+}
+#endif
+
+static char *itoa2_b10_u64(char *rbuf, uint64_t v)
+{
+	// Peel off 8 digits at a time until the rest fits in 32 bits so the bulk uses native 32-bit division
+	char *e;
+	while (v>0xFFFFFFFF)
+	{
+		uint32_t lo = v%100000000;
+		v = v/100000000;
+		e = rbuf-8;
+		rbuf = itoa2_b10_u32(rbuf, lo);
+		while (rbuf>e) *--rbuf = '0';
+	}
+	return itoa2_b10_u32(rbuf, v);
+}
+
+// Power of 2 radixes just need a shift and mask per digit, the rest a divide.  Made at each width that is
+// converted, so an 8 bit value never pays for 16 bit math and an int never for 32 bit (which on the AVR are
+// library calls).
+#define ITOA2_RADIX_FUNCS(suffix, type)                                      \
+static char *itoa2_pow2##suffix(char *rbuf, type v, char radix, char a)     \
+{                                                                            \
+	uint8_t s = (radix==2 ? 1 : radix==4 ? 2 : radix==8 ? 3 : radix==16 ? 4 : 5); \
+	uint8_t m = radix-1;                                                     \
+	uint8_t d;                                                               \
+	do {                                                                     \
+		d = v&m;                                                             \
+		v >>= s;                                                             \
+		*--rbuf = (d<=9 ? '0'+d : a+d-10);                                   \
+	} while (v);                                                             \
+	return rbuf;                                                             \
+}                                                                            \
+                                                                             \
+static char *itoa2_div##suffix(char *rbuf, type v, char radix, char a)      \
+{                                                                            \
+	char d;                                                                  \
+	do {                                                                     \
+		d = v%(uint8_t)radix;                                                \
+		v = v/(uint8_t)radix;                                                \
+		*--rbuf = (d<=9 ? '0'+d : a+d-10);                                   \
+	} while (v);                                                             \
+	return rbuf;                                                             \
+}
+
+ITOA2_RADIX_FUNCS(_8, uint8_t)
+ITOA2_RADIX_FUNCS(, unsigned int)
+#if UINT_MAX != 0xFFFFFFFF
+ITOA2_RADIX_FUNCS(_32, uint32_t)
+#endif
+ITOA2_RADIX_FUNCS(_64, uint64_t)
+
+char *itoa2_8(char *rbuf, uint8_t v, char radix, uint8_t flags)
+{
+	// As itoa2, for values that are known to be 8 bits (so never wider math than needed)
+	char a = ((flags&ITOA2_UCASE) ? 'A' : 'a');
+	char n = ((flags&ITOA2_SIGNED) && (v&0x80) ? 1 : 0);
+	if (n) v = -v;
+	*--rbuf = 0;
+#ifdef __AVR__
+	if (radix==10) rbuf = itoa2_b10_u8(rbuf, v);
+#else
+	if (radix==10) rbuf = itoa2_b10_u32(rbuf, v);
+#endif
+	else if (!(radix&(radix-1))) rbuf = itoa2_pow2_8(rbuf, v, radix, a);
+	else                         rbuf = itoa2_div_8(rbuf, v, radix, a);
+	if (n && !(flags&ITOA2_NOSIGN)) *--rbuf = '-';
+	return rbuf;
 }
 
 char *itoa2(char *rbuf, unsigned int v, char radix, uint8_t flags)
 {
 	// Simpler and cooler itoa, mostly for printf support
 	// rbuf should point to the end of a buffer (i.e. buffer+len) with at least 34 (base=2: 32bits, sign, null) bytes
+	// The radix specific paths are picked here so callers get them for free and output is identical
 	char a = ((flags&ITOA2_UCASE) ? 'A' : 'a');
 	char n = ((flags&ITOA2_SIGNED) && (v&INT_MIN) ? 1 : 0);
-	char d;
 	if (n) v = -v;
 	*--rbuf = 0;
-	do {
-		d = v%radix;
-		v = v/radix;
-		*--rbuf = (d<=9 ? '0'+d : a+d-10);
-	} while (v);
+#ifdef __AVR__
+	if (radix==10) rbuf = itoa2_b10_u16(rbuf, v);
+#else
+	if (radix==10) rbuf = itoa2_b10_u32(rbuf, v);
+#endif
+	else if (!(radix&(radix-1))) rbuf = itoa2_pow2(rbuf, v, radix, a);
+	else                         rbuf = itoa2_div(rbuf, v, radix, a);
 	if (n && !(flags&ITOA2_NOSIGN)) *--rbuf = '-';
 	return rbuf;
 }
 
-static char *strf_itoa(char *rbuffer, va_list *args, char radix, uint8_t iaflag, char *sign, int *length)
+char *itoa2_32(char *rbuf, uint32_t v, char radix, uint8_t flags)
 {
-	unsigned int v;
-	char *string;
-	v = va_arg(*args, unsigned int);
-	string = itoa2(rbuffer, v, radix, iaflag);
-	if (string[0]=='-') *sign='-', string++;
-	*length = rbuffer-string-1;
-	return string;
+	// As itoa2, for 32-bit values regardless of the size of int
+#if UINT_MAX == 0xFFFFFFFF
+	return itoa2(rbuf, v, radix, flags);
+#else
+	char a = ((flags&ITOA2_UCASE) ? 'A' : 'a');
+	char n = ((flags&ITOA2_SIGNED) && (v&0x80000000) ? 1 : 0);
+	if (n) v = -v;
+	*--rbuf = 0;
+	if      (radix==10)          rbuf = itoa2_b10_u32(rbuf, v);
+	else if (!(radix&(radix-1))) rbuf = itoa2_pow2_32(rbuf, v, radix, a);
+	else                         rbuf = itoa2_div_32(rbuf, v, radix, a);
+	if (n && !(flags&ITOA2_NOSIGN)) *--rbuf = '-';
+	return rbuf;
+#endif
+}
+
+char *itoa2_64(char *rbuf, uint64_t v, char radix, uint8_t flags)
+{
+	// As itoa2, but rbuf needs at least 66 (base=2: 64bits, sign, null) bytes
+	char a = ((flags&ITOA2_UCASE) ? 'A' : 'a');
+	char n = ((flags&ITOA2_SIGNED) && (v>>63) ? 1 : 0);
+	if (n) v = -v;
+	*--rbuf = 0;
+	if      (radix==10)          rbuf = itoa2_b10_u64(rbuf, v);
+	else if (!(radix&(radix-1))) rbuf = itoa2_pow2_64(rbuf, v, radix, a);
+	else                         rbuf = itoa2_div_64(rbuf, v, radix, a);
+	if (n && !(flags&ITOA2_NOSIGN)) *--rbuf = '-';
+	return rbuf;
 }
 
-/*
-char *strf_ftoa(char *rbuffer, va_list *args, int flags, char *sign, int *length)
+// Conversion buffer for the formatters, big enough for any itoa2 variant in use
+#if defined(LILLIB_CFG_CONV_LONGLONG) || ULONG_MAX > 0xFFFFFFFF
+#define STRF_BUFSIZE 66
+#else
+#define STRF_BUFSIZE 34
+#endif
+
+static char *strf_itoa(char *rbuffer, va_list *args, char size, char radix, uint8_t iaflag, char *sign, int *length)
 {
+	// Dispatch on the length modifier so each width gets the conversion sized for it
 	unsigned int v;
 	char *string;
-	v = va_arg(*args, double);
-	string = itoa2(rbuffer, v, radix, flags);
+	switch (size)
+	{
+		case 'H': // hh
+			string = itoa2_8(rbuffer, (uint8_t)va_arg(*args, unsigned int), radix, iaflag);
+			break;
+		case 'h':
+			v = va_arg(*args, unsigned int);
+			v = ((iaflag&ITOA2_SIGNED) ? (unsigned int)(int)(int16_t)v : (unsigned int)(uint16_t)v);
+			string = itoa2(rbuffer, v, radix, iaflag);
+			break;
+		case 'l':
+#if ULONG_MAX == 0xFFFFFFFF
+			string = itoa2_32(rbuffer, va_arg(*args, unsigned long), radix, iaflag);
+#else
+			string = itoa2_64(rbuffer, va_arg(*args, unsigned long), radix, iaflag);
+#endif
+			break;
+		case 'L': // ll
+#ifdef LILLIB_CFG_CONV_LONGLONG
+			string = itoa2_64(rbuffer, va_arg(*args, unsigned long long), radix, iaflag);
+#else
+			// Like floats, unsupported but the argument is still consumed
+			(void)va_arg(*args, unsigned long long);
+			string = rbuffer-6;
+			string[0]='<', string[1]='l', string[2]='l', string[3]='?', string[4]='>', string[5]=0;
+#endif
+			break;
+		default:
+			string = itoa2(rbuffer, va_arg(*args, unsigned int), radix, iaflag);
+			break;
+	}
 	if (string[0]=='-') *sign='-', string++;
 	*length = rbuffer-string-1;
 	return string;
 }
-*/
+
+#ifdef LILLIB_CFG_CONV_FLOAT
+// Float formatting without libm or soft-float: the double is unpacked by hand into a normalized
+// mantissa and binary exponent (a "diy fp", as in Grisu) and multiplied by a power of ten, also kept
+// as a diy fp, to get an integer holding the wanted digits.  The mantissa is 64 bits on the host and
+// 32 bits on the AVR (where double is a float), so digits are exact up to STRF_FP_DIGITS and then 0.
+#if __SIZEOF_DOUBLE__ == 8
+typedef uint64_t strf_fpm;
+#define STRF_FP_BITS      64
+#define STRF_FP_DIGITS    17
+#define STRF_FP_MAN_BITS  52
+#define STRF_FP_EXP_MAX   0x7FF
+#define STRF_FP_EXP_BIAS  1075
+#define STRF_FP_CHUNK     27                      // Largest k with 5^k < 2^64, so 10^k is exact
+#define STRF_FP_NCHUNK_F  0x9E74D1B791E07E48ULL   // 10^-CHUNK = F * 2^E
+#define STRF_FP_NCHUNK_E  -153
+#define STRF_FP_ITOA(rbuf, v) itoa2_64(rbuf, v, 10, 0)
+#else
+typedef uint32_t strf_fpm;
+#define STRF_FP_BITS      32
+#define STRF_FP_DIGITS    8
+#define STRF_FP_MAN_BITS  23
+#define STRF_FP_EXP_MAX   0xFF
+#define STRF_FP_EXP_BIAS  150
+#define STRF_FP_CHUNK     13
+#define STRF_FP_NCHUNK_F  0xE12E1342UL
+#define STRF_FP_NCHUNK_E  -75
+#define STRF_FP_ITOA(rbuf, v) itoa2_32(rbuf, v, 10, 0)
+#endif
+#define STRF_FP_HALF      (STRF_FP_BITS/2)
+#define STRF_FP_TOP       ((strf_fpm)1<<(STRF_FP_BITS-1))
+
+typedef struct { strf_fpm f; int e; } strf_fp;
+
+static strf_fpm strf_fp_mul2(strf_fpm a, strf_fpm b, strf_fpm *lo)
+{
+	// Full double width product as the return value:*lo, from half-width pieces
+	const strf_fpm m = ((strf_fpm)1<<STRF_FP_HALF)-1;
+	strf_fpm ah = a>>STRF_FP_HALF, al = a&m;
+	strf_fpm bh = b>>STRF_FP_HALF, bl = b&m;
+	strf_fpm ll = al*bl, hl = ah*bl, lh = al*bh;
+	strf_fpm t  = (ll>>STRF_FP_HALF) + (hl&m) + (lh&m);
+	*lo = (t<<STRF_FP_HALF) | (ll&m);
+	return ah*bh + (hl>>STRF_FP_HALF) + (lh>>STRF_FP_HALF) + (t>>STRF_FP_HALF);
+}
+
+static strf_fp strf_fp_mul(strf_fp a, strf_fp b)
+{
+	// Product rounded back to a normalized diy fp
+	strf_fpm lo;
+	strf_fp r;
+	r.f = strf_fp_mul2(a.f, b.f, &lo);
+	r.e = a.e + b.e + STRF_FP_BITS;
+	if (!(r.f&STRF_FP_TOP)) r.f = (r.f<<1)|(lo>>(STRF_FP_BITS-1)), lo <<= 1, r.e--;
+	if ((lo&STRF_FP_TOP) && !++r.f) r.f = STRF_FP_TOP, r.e++;
+	return r;
+}
+
+static strf_fp strf_fp_exact10(int b)
+{
+	// 10^b = 5^b * 2^b, exact for b<=CHUNK
+	strf_fp r;
+	r.f = 1, r.e = b;
+	while (b--) r.f *= 5;
+	while (!(r.f&STRF_FP_TOP)) r.f<<=1, r.e--;
+	return r;
+}
+
+static strf_fp strf_fp_pow10(int k)
+{
+	// 10^k = 10^b * (10^+-CHUNK)^n, so there are only a few roundings even for large k and none for
+	// 0<=k<=CHUNK
+	strf_fp r, c;
+	int n;
+	if (k<0) n = (STRF_FP_CHUNK-1-k)/STRF_FP_CHUNK, k += n*STRF_FP_CHUNK, c.f = STRF_FP_NCHUNK_F, c.e = STRF_FP_NCHUNK_E;
+	else     n = (k>0 ? (k-1)/STRF_FP_CHUNK : 0),   k -= n*STRF_FP_CHUNK, c = strf_fp_exact10(STRF_FP_CHUNK);
+	r = strf_fp_exact10(k);
+	while (n--) r = strf_fp_mul(r, c);
+	return r;
+}
+
+static strf_fpm strf_fp_scale(const strf_fp *x, int q)
+{
+	// round(x * 10^q), rounding on the full product.  When 10^q is exact the product is too, so ties can
+	// go to even like glibc does.
+	strf_fp p = strf_fp_pow10(q);
+	strf_fpm lo, hi = strf_fp_mul2(x->f, p.f, &lo);
+	strf_fpm n, rest;
+	char half, exact = (q>=0 && q<=STRF_FP_CHUNK);
+	int s = -(x->e + p.e);
+	if (s<=0)               return ~(strf_fpm)0; // Doesn't fit, not reachable with the q's used
+	if (s>2*STRF_FP_BITS)   return 0;
+	if (s==2*STRF_FP_BITS)  return hi>>(STRF_FP_BITS-1);
+	if (s>STRF_FP_BITS)
+	{
+		s -= STRF_FP_BITS;
+		n = hi>>s, half = (hi>>(s-1))&1, rest = lo|(hi&(((strf_fpm)1<<(s-1))-1));
+	}
+	else if (s==STRF_FP_BITS) n = hi, half = lo>>(STRF_FP_BITS-1), rest = lo<<1;
+	else n = (hi<<(STRF_FP_BITS-s))|(lo>>s), half = (lo>>(s-1))&1, rest = lo&(((strf_fpm)1<<(s-1))-1);
+	if (half && (rest || !exact || (n&1))) n++;
+	return n;
+}
+
+static strf_fpm strf_fp_ipow10(int n)
+{
+	strf_fpm r = 1;
+	while (n--) r *= 10;
+	return r;
+}
+
+static strf_fpm strf_fp_digits(const strf_fp *x, int n, int *k)
+{
+	// x rounded to n significant digits.  *k is an estimate of the decimal exponent of the first digit,
+	// off by at most one, and is corrected here.
+	strf_fpm N = strf_fp_scale(x, n-1-*k);
+	if      (N<strf_fp_ipow10(n-1)) (*k)--, N = strf_fp_scale(x, n-1-*k);
+	else if (N>=strf_fp_ipow10(n))  (*k)++, N = strf_fp_scale(x, n-1-*k);
+	if (N>=strf_fp_ipow10(n))       (*k)++, N /= 10; // Rounded up to the next power of 10
+	return N;
+}
+
+static char *strf_ftoa(char *buffer, va_list *args, char type, int prec, char *sign, int *length)
+{
+	union { double d; strf_fpm u; } v;
+	strf_fp x;
+	strf_fpm N;
+	char digits[STRF_FP_DIGITS+2];
+	const char *d;
+	char *o = buffer;
+	char ucase = (type>='A' && type<='Z');
+	char strip = 0;
+	int k = 0, kk, nd, m, i, exp;
+	v.d  = va_arg(*args, double);
+	type |= 0x20;
+	if (v.u&STRF_FP_TOP) *sign = '-';
+	exp = (v.u>>STRF_FP_MAN_BITS)&STRF_FP_EXP_MAX;
+	x.f = v.u&(((strf_fpm)1<<STRF_FP_MAN_BITS)-1);
+	if (exp==STRF_FP_EXP_MAX)
+	{
+		d = (x.f ? (ucase ? "NAN" : "nan") : (ucase ? "INF" : "inf"));
+		o[0]=d[0], o[1]=d[1], o[2]=d[2], o[3]=0;
+		*length = 3;
+		return buffer;
+	}
+	if (exp) x.f |= (strf_fpm)1<<STRF_FP_MAN_BITS, x.e = exp-STRF_FP_EXP_BIAS;
+	else     x.e = 1-STRF_FP_EXP_BIAS;
+	if (x.f)
+	{
+		while (!(x.f&STRF_FP_TOP)) x.f<<=1, x.e--;
+		k = (int)(((int32_t)(x.e+STRF_FP_BITS-1)*78913) >> 18); // floor(log2(x)*log10(2))
+	}
+	if (prec<0) prec = 6;
+	if (type=='g')
+	{
+		// The shorter of e/f style for prec significant digits, without trailing zeros
+		if (!prec) prec = 1;
+		if (x.f) strf_fp_digits(&x, (prec<STRF_FP_DIGITS ? prec : STRF_FP_DIGITS), &k);
+		if (k<-4 || k>=prec) type = 'e', prec = prec-1;
+		else                 type = 'f', prec = prec-1-k;
+		strip = 1;
+	}
+	if (type=='f')
+	{
+		if (!x.f || k+1+prec<=STRF_FP_DIGITS) N = (x.f ? strf_fp_scale(&x, prec) : 0), kk = -prec;
+		else                                  N = strf_fp_digits(&x, STRF_FP_DIGITS, &k), kk = k-STRF_FP_DIGITS+1;
+		d  = STRF_FP_ITOA(digits+sizeof(digits), N);
+		nd = digits+sizeof(digits)-1-d;
+		kk += nd-1; // Decimal exponent of d[0]
+		m = (kk>0 ? kk : 0);
+		if (m+2>STRF_BUFSIZE-1) type = 'e'; // Too big to write out, fall back to exponent format
+		else
+		{
+			if (m+2+prec>STRF_BUFSIZE-1) prec = STRF_BUFSIZE-1-m-2;
+			for ( ; m>=-prec; m--)
+			{
+				if (m==-1) *o++ = '.';
+				i = kk-m;
+				*o++ = (i>=0 && i<nd ? d[i] : '0');
+			}
+		}
+	}
+	if (type=='e')
+	{
+		if (prec>STRF_BUFSIZE-1-8) prec = STRF_BUFSIZE-1-8;
+		nd = (prec+1<STRF_FP_DIGITS ? prec+1 : STRF_FP_DIGITS);
+		N  = (x.f ? strf_fp_digits(&x, nd, &k) : 0);
+		d  = STRF_FP_ITOA(digits+sizeof(digits), N);
+		*o++ = d[0];
+		if (prec) *o++ = '.';
+		for (i=1; i<=prec; i++) *o++ = (i<nd && x.f ? d[i] : '0');
+	}
+	if (strip && prec)
+	{
+		while (o[-1]=='0') o--;
+		if (o[-1]=='.') o--;
+	}
+	if (type=='e')
+	{
+		if (!x.f) k = 0;
+		*o++ = (ucase ? 'E' : 'e');
+		*o++ = (k<0 ? '-' : '+');
+		if (k<0) k = -k;
+		if (k>=100) *o++ = '0'+k/100, k %= 100;
+		*o++ = '0'+k/10;
+		*o++ = '0'+k%10;
+	}
+	*o = 0;
+	*length = o-buffer;
+	return buffer;
+}
+#endif
+
+// On 64-bit hosts decimal digits are parsed 8 at a time (SWAR, as in fast_float): one unaligned load,
+// a mask to find the first non-digit and 3 multiplies to combine them.  The load may read past the end of
+// the string, but never past the page it ends in, so it can't fault.  It is still an out of bounds read
+// though, so under ASan the scalar loop does it all (as for the word scans in str.c).
+#ifdef __x86_64__
+#if defined(__SANITIZE_ADDRESS__)
+#define STRTOL_NO_SWAR
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define STRTOL_NO_SWAR
+#endif
+#endif
+#ifndef STRTOL_NO_SWAR
+#define STRTOL_SWAR
+#endif
+#endif
+
+#ifdef STRTOL_SWAR
+#define STRTOL_SWAR_VMAX ((INT_MAX-99999999)/100000000) // Largest v for which v*10^8+99999999 can't overflow
+
+static const uint32_t strtol_swar_p10[9] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000 };
+
+// Parses up to 8 leading decimal digits of str into *d and returns how many there were
+static int strtol_swar(const char *str, uint32_t *d)
+{
+	uint64_t t, m;
+	int n;
+	if (((unsigned long)str & 0xFFF) > 0x1000-8) return 0; // Load would cross a page, leave it to the scalar loop
+	__builtin_memcpy(&t, str, 8);
+	// Digits become 0-9 and anything else gets a byte >=10 (or with the high bit set).  Borrows/carries only
+	// go towards later chars, so the first non-digit is always found correctly.
+	t -= 0x3030303030303030;
+	m  = (t | (t + 0x7676767676767676)) & 0x8080808080808080;
+	n  = (m ? __builtin_ctzll(m)>>3 : 8);
+	if (!n) return 0;
+	// Shift the digits to the top, leaving leading zeros, and combine pairs, then quads, then the 8
+	t <<= 8*(8-n);
+	t = (t*10    + (t>>8))  & 0x00FF00FF00FF00FF;
+	t = (t*100   + (t>>16)) & 0x0000FFFF0000FFFF;
+	t = (t*10000 + (t>>32)) & 0xFFFFFFFF;
+	*d = (uint32_t)t;
+	return n;
+}
+
+// Consumes digits 8 at a time while that can't overflow, leaving any others to the scalar loop
+#define STRTOL_SWAR_DIGITS(str, v, f)                                        \
+	do {                                                                     \
+		uint32_t _d; int _n;                                                 \
+		while (v<=STRTOL_SWAR_VMAX && (_n=strtol_swar(str, &_d)))            \
+		{                                                                    \
+			v = v*strtol_swar_p10[_n] + _d, str += _n, f = 1;                \
+			if (_n<8) break;                                                 \
+		}                                                                    \
+	} while (0)
+#endif
 
 int qstrtol(const char *str, const char **end, char radix)
 {
@@ -66,6 +573,9 @@ int qstrtol(const char *str, const char **end, char radix)
 	maxv = (n ? -(unsigned int)INT_MIN : INT_MAX);
 	maxd = maxv % radix;
 	maxv = maxv / radix;
+#ifdef STRTOL_SWAR
+	if (radix==10) STRTOL_SWAR_DIGITS(str, v, f);
+#endif
 	while (1)
 	{
 		c = *str++;
@@ -89,6 +599,9 @@ int strtol_b10(const char *str, const char **end)
 	if (end) *end = str;
 	while (isspace((uint8_t)(c=*str))) str++;
 	if (c=='+') str++; else if (c=='-') n=1, str++, maxd=8;
+#ifdef STRTOL_SWAR
+	STRTOL_SWAR_DIGITS(str, v, f);
+#endif
 	while (1)
 	{
 		c = *str++;
@@ -107,6 +620,9 @@ int strtol_b10u(const char *str, const char **end)
 	char c, f = 0;
 	if (end) *end = str;
 	while (isspace((uint8_t)(*str))) str++;
+#ifdef STRTOL_SWAR
+	STRTOL_SWAR_DIGITS(str, v, f);
+#endif
 	while (1)
 	{
 		c = *str++;
@@ -132,214 +648,412 @@ int strtol_b10u_micro(const char *str, const char **end)
 	return v;
 }
 
+// Fixed point decimal parsing, the inverse of %$: "12.34" with 2 decimals is 1234.  Digits past decimals
+// are consumed and round (half away from zero), missing ones are zeros.  Overflow saturates to max (or
+// -max-1) and consumes all the digits, as strtol_b10.  "12." and ".5" parse, a lone "." doesn't.
+static int32_t strtofix_b10(const char *str, const char **end, uint8_t decimals, uint32_t max)
+{
+	uint32_t maxv, v = 0;
+	char c, maxd, n = 0, f = 0, r = 0;
+	int i = -1; // Fraction digits so far, -1 before the '.'
+	if (end) *end = str;
+	while (isspace((uint8_t)(c=*str))) str++;
+	if (c=='+') str++; else if (c=='-') n=1, str++, max++;
+	maxv = max/10, maxd = max%10;
+	while (1)
+	{
+		c = *str;
+		if (c=='.' && i<0) { i = 0, str++; continue; }
+		if (c>='0' && c<='9') c = c-'0', str++; else break;
+		if (!f) f = 1;
+		if (i>=decimals) { if (i==decimals) r = (c>=5), i++; continue; }
+		if (i>=0) i++;
+		if (f==2) continue;
+		if (v<maxv || (v==maxv && c<=maxd)) v*=10, v+=c; else f=2;
+	}
+	if (!f) return 0;
+	if (end) *end = str;
+	for (i=(i<0 ? 0 : i); f==1 && i<decimals; i++)
+		if (v<=maxv) v*=10; else f=2;
+	if (f==1 && r) f = (v<max ? v++, 1 : 2);
+	if (f==2) v = max;
+	return (int32_t)(n ? 0-v : v);
+}
+
+int32_t strtofix(const char *str, const char **end, uint8_t decimals)
+{
+	return strtofix_b10(str, end, decimals, 0x7FFFFFFF);
+}
+
+int16_t strtofix16(const char *str, const char **end, uint8_t decimals)
+{
+	return (int16_t)strtofix_b10(str, end, decimals, 0x7FFF);
+}
+
+// As strtofix, but to a binary fixed point (Q format) number with bits (at most 28) fraction bits, so
+// "1.5" with 16 bits is 0x18000 (as printed by %k).  The fraction rounds to the nearest bit, except with
+// 28 bits, where it is truncated.
+int32_t strtofix_q(const char *str, const char **end, uint8_t bits)
+{
+	uint32_t maxv, v = 0, r = 0, max;
+	const char *dot, *e;
+	char c, maxd, n = 0, f = 0;
+	if (bits>28) bits = 28;
+	if (end) *end = str;
+	while (isspace((uint8_t)(c=*str))) str++;
+	if (c=='+') str++; else if (c=='-') n=1, str++;
+	max  = 0x7FFFFFFFUL + n;
+	maxv = (max>>bits)/10, maxd = (max>>bits)%10;
+	for ( ; (c=*str)>='0' && c<='9'; str++)
+	{
+		c = c-'0';
+		if (!f) f = 1;
+		if (f==2) continue;
+		if (v<maxv || (v==maxv && c<=maxd)) v*=10, v+=c; else f=2;
+	}
+	if (*str=='.')
+	{
+		for (dot=str++; (c=*str)>='0' && c<='9'; str++) if (!f) f = 1;
+		// The fraction (its first 9 digits are plenty) to Q0.28, last digit first
+		for (e=(str<dot+10 ? str : dot+10); --e>dot; ) r = (r + ((uint32_t)(*e-'0')<<28)) / 10;
+	}
+	if (!f) return 0;
+	if (end) *end = str;
+	if (f==1) v = (v<<bits) + ((r + (bits<28 ? (uint32_t)1<<(27-bits) : 0)) >> (28-bits));
+	if (f==2 || v>max) v = max;
+	return (int32_t)(n ? 0-v : v);
+}
+
+// Parses a list of up to max integers separated by spaces, tabs and/or commas, ending at the end of the
+// line (NUL, CR or LF).  Returns the number parsed, and *end is left at the end of the line or, if there
+// was an error, at the start of the field that couldn't be parsed (field number = return value).  Fields
+// that overflow are clamped as by qstrtol.
+int parse_ints(const char *line, char radix, int *out, int max, const char **end)
+{
+	const char *e;
+	int n = 0;
+	while (1)
+	{
+		while (*line==' ' || *line=='\t' || *line==',') line++;
+		if (!*line || *line=='\n' || *line=='\r' || n>=max) break;
+		out[n] = qstrtol(line, &e, radix);
+		if (e==line) break;
+		if (*e && *e!=' ' && *e!='\t' && *e!=',' && *e!='\n' && *e!='\r') break; // Trailing junk
+		n++, line = e;
+	}
+	if (end) *end = line;
+	return n;
+}
+
+// Inserts a '.' prec digits from the end of a number converted to end at buffer+STRF_BUFSIZE-1,
+// zero filling if it is shorter than that
+static char *strf_fixdot(char *buffer, char *content, int *length, int prec)
+{
+	int i;
+	while (*length<prec) *--content='0', (*length)++;
+	for (i=0;i<=prec;i++) buffer[STRF_BUFSIZE-1-i]=buffer[STRF_BUFSIZE-2-i];
+	buffer[STRF_BUFSIZE-2-prec]='.', (*length)++;
+	return content;
+}
+
+// A converted format spec, written out as: lpad*fill, sign, cpad*fill, content[length], rpad*fill
+// content is in flash (PROGMEM) if pgm is set
+typedef struct
+{
+	const char *content;
+	int length;
+	int lpad, cpad, rpad;
+	char fill;
+	char sign;
+	char pgm;
+} strf_field;
+
+// Next content char of a field, or 0 at its end
+static char strf_field_getc(strf_field *f)
+{
+	if (f->length-- <= 0) return 0;
+	return (f->pgm ? pgm_read_byte(f->content++) : *f->content++);
+}
+
+// Parses the spec following a '%' and converts its argument into buffer (STRF_BUFSIZE bytes).
+// Returns fmt advanced past the spec.  This is shared by all the formatters so they only differ in how
+// the field gets written.
+static const char *strf_conv(const char *fmt, va_list *args, char *buffer, strf_field *f)
+{
+	// Specifiers
+	char fill  = ' ';
+	char align = '>';
+	char sign  = 0;
+	char size  = 0;
+	char type  = 0;
+	char pgm   = 0;
+	int prec  = -1;
+	int width = -1;
+	// Data
+	const char *content = buffer;
+	int length;
+	// Read spec
+	if (*fmt && (fmt[1]=='-' || fmt[1]=='<' || fmt[1]=='>' || fmt[1]=='=' || fmt[1]=='^')) fill = *fmt++, align = *fmt++;
+	else if (*fmt=='-' || *fmt=='<' || *fmt=='>' || *fmt=='=' || *fmt=='^')                align = *fmt++;
+	if (*fmt=='+' || *fmt==' ')                     sign = *fmt++;
+	if (*fmt=='0')                                  fill = '0', align = '=', fmt++;
+	if (*fmt>='0' && *fmt<='9')                     width = strtol_b10u_micro(fmt, &fmt);
+	else if (*fmt=='*')                             width = va_arg(*args, int), fmt+=1;
+	if (fmt[0]=='.' && fmt[1]>='0' && fmt[1]<='9')  prec = strtol_b10u_micro(fmt+1, &fmt);
+	else if (fmt[0]=='.' && fmt[1]=='*')            prec = va_arg(*args, int), fmt+=2;
+	else if (fmt[0]=='.')                           prec = 0, fmt+=1;
+	if (fmt[0]=='h')                                size = (fmt[1]=='h' ? 'H' : 'h'), fmt += (fmt[1]=='h' ? 2 : 1);
+	else if (fmt[0]=='l')                           size = (fmt[1]=='l' ? 'L' : 'l'), fmt += (fmt[1]=='l' ? 2 : 1);
+	type = *fmt++;
+	// Apply format
+	switch (type)
+	{
+		// Integer
+		case 'd':
+		case 'i': content = strf_itoa(buffer+STRF_BUFSIZE, args, size, 10, ITOA2_SIGNED, &sign, &length); break;
+		case 'u': content = strf_itoa(buffer+STRF_BUFSIZE, args, size, 10,            0, &sign, &length); break;
+		case 'x': content = strf_itoa(buffer+STRF_BUFSIZE, args, size, 16,            0, &sign, &length); break;
+		case 'X': content = strf_itoa(buffer+STRF_BUFSIZE, args, size, 16,  ITOA2_UCASE, &sign, &length); break;
+		case 'o': content = strf_itoa(buffer+STRF_BUFSIZE, args, size,  8,            0, &sign, &length); break;
+		case 'b': content = strf_itoa(buffer+STRF_BUFSIZE, args, size,  2,            0, &sign, &length); break;
+		case 'p': content = strf_itoa(buffer+STRF_BUFSIZE, args, size, 16,  ITOA2_UCASE, &sign, &length); break;
+		case '$':
+			if (prec<0)  prec = 2;
+			if (prec>32) prec = 32;
+			content = strf_itoa(buffer+STRF_BUFSIZE-1, args, size, 10, ITOA2_SIGNED, &sign, &length);
+			content = strf_fixdot(buffer, (char *)content, &length, prec);
+			break;
+		case 'k':
+		case 'K':
+		{
+			// Q16.16 binary fixed point, signed or unsigned (like the TR 18037 accum formats), to prec digits.
+			// 16 fraction bits are ~4.8 digits, and capping prec at 4 keeps the scaling within 32 bits.
+			uint32_t v = va_arg(*args, uint32_t);
+			uint16_t p10 = 1;
+			if (prec<0) prec = 4;
+			if (prec>4) prec = 4;
+			for (length=0; length<prec; length++) p10 *= 10;
+			if (type=='k' && (v&0x80000000)) sign = '-', v = -v;
+			v = (v>>16)*p10 + (((v&0xFFFF)*p10 + 0x8000)>>16);
+			content = itoa2_32(buffer+STRF_BUFSIZE-1, v, 10, 0);
+			length  = buffer+STRF_BUFSIZE-2-content;
+			content = strf_fixdot(buffer, (char *)content, &length, prec);
+			break;
+		}
+		// Float
+#ifdef LILLIB_CFG_CONV_FLOAT
+		case 'f':
+		case 'F':
+		case 'e':
+		case 'E':
+		case 'g':
+		case 'G': content = strf_ftoa(buffer, args, type, prec, &sign, &length); break;
+#else
+		case 'f':
+		case 'F':
+		case 'e':
+		case 'E':
+		case 'g':
+		case 'G':
+#endif
+		case 'a':
+		case 'A':
+			va_arg(*args, double);
+			content = "<float?>";
+			length  = 8;
+			break;
+		// String
+		case 's':
+			content = va_arg(*args, const char*);
+			length  = qstrlen(content);
+			sign    = 0;
+			if (prec>=0 && prec<length) length = prec;
+			break;
+		case 'S':
+			// String in flash (as avr-libc's printf), same as %s off the AVR
+			content = va_arg(*args, const char*);
+			length  = qstrlen_P(content);
+			sign    = 0;
+			pgm     = 1;
+			if (prec>=0 && prec<length) length = prec;
+			break;
+		case 'c':
+			buffer[0] = (char)va_arg(*args, int);
+			buffer[1] = 0;
+			length    = (buffer[0] ? 1 : 0);
+			sign      = 0;
+			break;
+
+		case '%': length=1; buffer[0]='%'; break;
+		case  0 : length=2; buffer[0]='%'; buffer[1]='?';  fmt--; break;
+		default : length=2; buffer[0]='%'; buffer[1]=type; break;
+	}
+	// Padding
+	f->lpad = f->cpad = f->rpad = 0;
+	if (sign) length++;
+	if (length<width)
+	{
+		if (align=='<' || align=='-') f->rpad = (width-length);
+		if (align=='=')               f->cpad = (width-length);
+		if (align=='>')               f->lpad = (width-length);
+		if (align=='^')               f->lpad = (width-length)/2, f->rpad = (width-length-f->lpad);
+	}
+	if (sign) length--;
+	f->content = content;
+	f->length  = length;
+	f->fill    = fill;
+	f->sign    = sign;
+	f->pgm     = pgm;
+	return fmt;
+}
+
+// strf_conv for a format string in flash.  The spec is copied to RAM first, so specs are limited to
+// 23 chars (far more than any sane one needs).
+static const char *strf_conv_P(const char *fmt, va_list *args, char *buffer, strf_field *f)
+{
+	char spec[24];
+	uint8_t i;
+	for (i=0; i<sizeof(spec)-1 && (spec[i]=pgm_read_byte(fmt+i)); i++);
+	spec[i] = 0;
+	return fmt + (strf_conv(spec, args, buffer, f) - spec);
+}
+
+static void strf_print_field(strf_putc putc, strf_field *f)
+{
+	char c;
+	while (f->lpad--  ) putc(f->fill);
+	if    (f->sign    ) putc(f->sign);
+	while (f->cpad--  ) putc(f->fill);
+	while ((c=strf_field_getc(f))) putc(c);
+	while (f->rpad--  ) putc(f->fill);
+}
+
+// Writes what fits of a field to buf[n..cap) and returns n advanced by the field's full length
+static int strf_sprint_field(char *buf, int cap, int n, strf_field *f)
+{
+	int end = n + f->lpad + (f->sign ? 1 : 0) + f->cpad + f->length + f->rpad;
+	char c;
+	if (end<=cap)
+	{
+		// Common case of it all fitting, no need to check each char
+		if (f->lpad) qmemset(buf+n, f->fill, f->lpad), n += f->lpad;
+		if (f->sign) buf[n++] = f->sign;
+		if (f->cpad) qmemset(buf+n, f->fill, f->cpad), n += f->cpad;
+		if (!f->pgm) qmemcpy(buf+n, f->content, f->length), n += f->length;
+		else while ((c=strf_field_getc(f))) buf[n++] = c;
+		if (f->rpad) qmemset(buf+n, f->fill, f->rpad);
+	}
+	else if (n<cap)
+	{
+		while (f->lpad-- > 0 && n<cap) buf[n++] = f->fill;
+		if    (f->sign       && n<cap) buf[n++] = f->sign;
+		while (f->cpad-- > 0 && n<cap) buf[n++] = f->fill;
+		while (n<cap && (c=strf_field_getc(f))) buf[n++] = c;
+		while (f->rpad-- > 0 && n<cap) buf[n++] = f->fill;
+	}
+	return end;
+}
+
 void strf_print(strf_putc putc, const char *fmt, va_list args)
 {
-	char buffer[34];
+	char buffer[STRF_BUFSIZE];
+	strf_field f;
 	while (*fmt)
 	{
 		if (fmt[0]!='%') putc(*fmt++);
-		else
-		{
-			// Specifiers
-			char fill  = ' ';
-			char align = '>';
-			char sign  = 0;
-			char type  = 0;
-			int prec  = -1;
-			int width = -1;
-			// Data
-			const char *content = buffer;
-			int length;
-			// Read spec
-			fmt++;
-			if (*fmt && (fmt[1]=='-' || fmt[1]=='<' || fmt[1]=='>' || fmt[1]=='=' || fmt[1]=='^')) fill = *fmt++, align = *fmt++;
-			else if (*fmt=='-' || *fmt=='<' || *fmt=='>' || *fmt=='=' || *fmt=='^')                align = *fmt++;
-			if (*fmt=='+' || *fmt==' ')                     sign = *fmt++;
-			if (*fmt=='0')                                  fill = '0', align = '=', fmt++;
-			if (*fmt>='0' && *fmt<='9')                     width = strtol_b10u_micro(fmt, &fmt);
-			else if (*fmt=='*')                             width = va_arg(args, int), fmt+=1;
-			if (fmt[0]=='.' && fmt[1]>='0' && fmt[1]<='9')  prec = strtol_b10u_micro(fmt+1, &fmt);
-			else if (fmt[0]=='.' && fmt[1]=='*')            prec = va_arg(args, int), fmt+=2;
-			else if (fmt[0]=='.')                           prec = 0, fmt+=1;
-			type = *fmt++;
-			// Apply format
-			switch (type)
-			{
-				// Integer
-				case 'd':
-				case 'i': content = strf_itoa(buffer+34, VA_LIST_PTR(args), 10, ITOA2_SIGNED, &sign, &length); break;
-				case 'u': content = strf_itoa(buffer+34, VA_LIST_PTR(args), 10,            0, &sign, &length); break;
-				case 'x': content = strf_itoa(buffer+34, VA_LIST_PTR(args), 16,            0, &sign, &length); break;
-				case 'X': content = strf_itoa(buffer+34, VA_LIST_PTR(args), 16,  ITOA2_UCASE, &sign, &length); break;
-				case 'o': content = strf_itoa(buffer+34, VA_LIST_PTR(args),  8,            0, &sign, &length); break;
-				case 'b': content = strf_itoa(buffer+34, VA_LIST_PTR(args),  2,            0, &sign, &length); break;
-				case 'p': content = strf_itoa(buffer+34, VA_LIST_PTR(args), 16,  ITOA2_UCASE, &sign, &length); break;
-				case '$':
-				{
-					int i;
-					if (prec<0)  prec = 2;
-					if (prec>32) prec = 32;
-					content = strf_itoa(buffer+34-1, VA_LIST_PTR(args), 10, ITOA2_SIGNED, &sign, &length);
-					while (length<prec) *(char*)(--content)='0', length++;
-					for (i=0;i<=prec;i++) buffer[33-i]=buffer[32-i];
-					buffer[32-prec]='.', length++;
-					break;
-				}
-				// Float
-				case 'f':
-				case 'F':
-				case 'e':
-				case 'E':
-				case 'g':
-				case 'G':
-				case 'a':
-				case 'A':
-					va_arg(args, double);
-					content = "<float?>";
-					length  = 8;
-					break;
-				// String
-				case 's':
-					content = va_arg(args, const char*);
-					length  = qstrlen(content);
-					sign    = 0;
-					if (prec>=0 && prec<length) length = prec;
-					break;
-				case 'c':
-					buffer[0] = (char)va_arg(args, int);
-					buffer[1] = 0;
-					length    = 1;
-					sign      = 0;
-					break;
-				
-				case '%': length=1; buffer[0]='%'; break;
-				case  0 : length=2; buffer[0]='%'; buffer[1]='?';  fmt--; break;
-				default : length=2; buffer[0]='%'; buffer[1]=type; break;
-			}
-			// Pad and write
-			{
-				int lpad=0, cpad=0, rpad=0;
-				if (sign) length++;
-				if (length<width)
-				{
-					if (align=='<' || align=='-') rpad = (width-length);
-					if (align=='=')               cpad = (width-length);
-					if (align=='>')               lpad = (width-length);
-					if (align=='^')               lpad = (width-length)/2, rpad = (width-length-lpad);
-				}
-				while (lpad--  ) putc(fill);
-				if    (sign    ) putc(sign);
-				while (cpad--  ) putc(fill);
-				while (*content && length--) putc(*content++);
-				while (rpad--  ) putc(fill);
-			}
-		}
+		else fmt = strf_conv(fmt+1, VA_LIST_PTR(args), buffer, &f), strf_print_field(putc, &f);
+	}
+}
+
+void strf_print_P(strf_putc putc, const char *fmt, va_list args)
+{
+	char buffer[STRF_BUFSIZE];
+	strf_field f;
+	char c;
+	while ((c=pgm_read_byte(fmt)))
+	{
+		if (c!='%') putc(c), fmt++;
+		else fmt = strf_conv_P(fmt+1, VA_LIST_PTR(args), buffer, &f), strf_print_field(putc, &f);
 	}
 }
 
-void strf_sprint(char *buf, int size, const char *fmt, va_list args)
+// Writes a field in spans rather than chars.  Content in flash is copied through buffer.
+static void strf_write_field(strf_write write, strf_field *f, char *buffer)
 {
-	char buffer[34];
+	int n, i;
+	if (f->lpad) write(NULL, f->lpad, f->fill);
+	if (f->sign) write(&f->sign, 1, 0);
+	if (f->cpad) write(NULL, f->cpad, f->fill);
+	if (!f->pgm) { if (f->length>0) write(f->content, f->length, 0); }
+	else for ( ; f->length>0; f->length-=n)
+	{
+		n = (f->length<STRF_BUFSIZE ? f->length : STRF_BUFSIZE);
+		for (i=0; i<n; i++) buffer[i] = pgm_read_byte(f->content++);
+		write(buffer, n, 0);
+	}
+	if (f->rpad) write(NULL, f->rpad, f->fill);
+}
+
+// As strf_print, but output goes in runs of literal text, converted content and padding, so a sink
+// that can copy in bulk (e.g. into a UART ring buffer) doesn't pay a call per char
+void strf_print_bulk(strf_write write, const char *fmt, va_list args)
+{
+	char buffer[STRF_BUFSIZE];
+	strf_field f;
+	const char *s;
 	while (*fmt)
 	{
-		if (fmt[0]!='%') { if (size) *buf++ = *fmt++, size--; }
-		else
-		{
-			// Specifiers
-			char fill  = ' ';
-			char align = '>';
-			char sign  = 0;
-			char type  = 0;
-			int prec  = -1;
-			int width = -1;
-			// Data
-			const char *content = buffer;
-			int length;
-			// Read spec
-			fmt++;
-			if (*fmt && (fmt[1]=='-' || fmt[1]=='<' || fmt[1]=='>' || fmt[1]=='=' || fmt[1]=='^')) fill = *fmt++, align = *fmt++;
-			else if (*fmt=='-' || *fmt=='<' || *fmt=='>' || *fmt=='=' || *fmt=='^')                align = *fmt++;
-			if (*fmt=='+' || *fmt==' ')                     sign = *fmt++;
-			if (*fmt=='0')                                  fill = '0', align = '=', fmt++;
-			if (*fmt>='0' && *fmt<='9')                     width = strtol_b10u_micro(fmt, &fmt);
-			else if (*fmt=='*')                             width = va_arg(args, int), fmt+=1;
-			if (fmt[0]=='.' && fmt[1]>='0' && fmt[1]<='9')  prec = strtol_b10u_micro(fmt+1, &fmt);
-			else if (fmt[0]=='.' && fmt[1]=='*')            prec = va_arg(args, int), fmt+=2;
-			else if (fmt[0]=='.')                           prec = 0, fmt+=1;
-			type = *fmt++;
-			// Apply format
-			switch (type)
-			{
-				// Integer
-				case 'd':
-				case 'i': content = strf_itoa(buffer+34, VA_LIST_PTR(args), 10, ITOA2_SIGNED, &sign, &length); break;
-				case 'u': content = strf_itoa(buffer+34, VA_LIST_PTR(args), 10,            0, &sign, &length); break;
-				case 'x': content = strf_itoa(buffer+34, VA_LIST_PTR(args), 16,            0, &sign, &length); break;
-				case 'X': content = strf_itoa(buffer+34, VA_LIST_PTR(args), 16,  ITOA2_UCASE, &sign, &length); break;
-				case 'o': content = strf_itoa(buffer+34, VA_LIST_PTR(args),  8,            0, &sign, &length); break;
-				case 'b': content = strf_itoa(buffer+34, VA_LIST_PTR(args),  2,            0, &sign, &length); break;
-				case 'p': content = strf_itoa(buffer+34, VA_LIST_PTR(args), 16,  ITOA2_UCASE, &sign, &length); break;
-				case '$':
-				{
-					int i;
-					if (prec<0)  prec = 2;
-					if (prec>32) prec = 32;
-					content = strf_itoa(buffer+34-1, VA_LIST_PTR(args), 10, ITOA2_SIGNED, &sign, &length);
-					while (length<prec) *(char*)(--content)='0', length++;
-					for (i=0;i<=prec;i++) buffer[33-i]=buffer[32-i];
-					buffer[32-prec]='.', length++;
-					break;
-				}
-				// Float
-				case 'f':
-				case 'F':
-				case 'e':
-				case 'E':
-				case 'g':
-				case 'G':
-				case 'a':
-				case 'A':
-					va_arg(args, double);
-					content = "<float?>";
-					length  = 8;
-					break;
-				// String
-				case 's':
-					content = va_arg(args, const char*);
-					length  = qstrlen(content);
-					sign    = 0;
-					if (prec>=0 && prec<length) length = prec;
-					break;
-				case 'c':
-					buffer[0] = (char)va_arg(args, int);
-					buffer[1] = 0;
-					length    = 1;
-					sign      = 0;
-					break;
-				
-				case '%': length=1; buffer[0]='%'; break;
-				case  0 : length=2; buffer[0]='%'; buffer[1]='?';  fmt--; break;
-				default : length=2; buffer[0]='%'; buffer[1]=type; break;
-			}
-			// Pad and write
-			{
-				int lpad=0, cpad=0, rpad=0;
-				if (sign) length++;
-				if (length<width)
-				{
-					if (align=='<' || align=='-') rpad = (width-length);
-					if (align=='=')               cpad = (width-length);
-					if (align=='>')               lpad = (width-length);
-					if (align=='^')               lpad = (width-length)/2, rpad = (width-length-lpad);
-				}
-				while (lpad--  && size) *buf++ = fill, size--;
-				if    (sign    && size) *buf++ = sign, size--;
-				while (cpad--  && size) *buf++ = fill, size--;
-				while (*content && length-- && size) *buf++ = *content++, size--;
-				while (rpad--  && size) *buf++ = fill, size--;
-			}
-		}
+		for (s=fmt; *fmt && *fmt!='%'; fmt++);
+		if (fmt!=s) write(s, fmt-s, 0);
+		if (*fmt) fmt = strf_conv(fmt+1, VA_LIST_PTR(args), buffer, &f), strf_write_field(write, &f, buffer);
 	}
-	if (size) *buf++ = 0;
 }
 
+void strf_print_bulk_P(strf_write write, const char *fmt, va_list args)
+{
+	char buffer[STRF_BUFSIZE];
+	strf_field f;
+	char c;
+	int n;
+	while (pgm_read_byte(fmt))
+	{
+		// Literal runs are copied out of flash a buffer at a time
+		for (n=0; n<STRF_BUFSIZE && (c=pgm_read_byte(fmt)) && c!='%'; n++, fmt++) buffer[n] = c;
+		if (n) write(buffer, n, 0);
+		else fmt = strf_conv_P(fmt+1, VA_LIST_PTR(args), buffer, &f), strf_write_field(write, &f, buffer);
+	}
+}
+
+// Formats into buf like snprintf: at most size-1 chars are written and always NUL terminated (if size>0).
+// Returns the full length of the output, which may be more than was written.  With buf==NULL or size==0
+// nothing is written, so it just measures the output.
+int strf_sprint(char *buf, int size, const char *fmt, va_list args)
+{
+	char buffer[STRF_BUFSIZE];
+	strf_field f;
+	int cap = (buf && size>0 ? size-1 : 0);
+	int n = 0;
+	while (*fmt)
+	{
+		if (fmt[0]!='%') { if (n<cap) buf[n] = *fmt; n++, fmt++; }
+		else fmt = strf_conv(fmt+1, VA_LIST_PTR(args), buffer, &f), n = strf_sprint_field(buf, cap, n, &f);
+	}
+	if (buf && size>0) buf[n<cap ? n : cap] = 0;
+	return n;
+}
+
+int strf_sprint_P(char *buf, int size, const char *fmt, va_list args)
+{
+	char buffer[STRF_BUFSIZE];
+	strf_field f;
+	int cap = (buf && size>0 ? size-1 : 0);
+	int n = 0;
+	char c;
+	while ((c=pgm_read_byte(fmt)))
+	{
+		if (c!='%') { if (n<cap) buf[n] = c; n++, fmt++; }
+		else fmt = strf_conv_P(fmt+1, VA_LIST_PTR(args), buffer, &f), n = strf_sprint_field(buf, cap, n, &f);
+	}
+	if (buf && size>0) buf[n<cap ? n : cap] = 0;
+	return n;
+}
@@ -0,0 +1,422 @@
+#include "lillib.h"
+
+// CRC-16/CCITT-FALSE (poly 0x1021, MSB first, as XMODEM but starting at 0xFFFF), CRC-16/MODBUS (poly 0x8005,
+// reflected) and CRC-32 (as zlib, Ethernet and PNG).  Each takes the CRC so far (the _INIT value to start)
+// and returns it with n more bytes, so messages can go through in pieces.
+//
+// The _update functions go a byte at a time with 256 entry tables (512 or 1K bytes, in flash on the AVR and
+// aligned so its asm loops only have to set ZL), or on hosts with LILLIB_CFG_CRC_SLICE8, 8 bytes at a time
+// with 8 tables made at startup.  The _nibble ones use 16 entry tables (32 or 64 bytes) and take several
+// times as long, for when flash is tight (and LILLIB_CFG_CRC_NIBBLE makes _update use them).  The tables
+// only get linked in if their functions are used.
+
+// The byte tables, split into their low to high bytes (so the AVR can lpm them straight into registers)
+static const uint8_t crc16_ccitt_table[2][256] PROGMEM __attribute__((aligned(256))) = {
+	{
+		0x00, 0x21, 0x42, 0x63, 0x84, 0xA5, 0xC6, 0xE7, 0x08, 0x29, 0x4A, 0x6B, 0x8C, 0xAD, 0xCE, 0xEF,
+		0x31, 0x10, 0x73, 0x52, 0xB5, 0x94, 0xF7, 0xD6, 0x39, 0x18, 0x7B, 0x5A, 0xBD, 0x9C, 0xFF, 0xDE,
+		0x62, 0x43, 0x20, 0x01, 0xE6, 0xC7, 0xA4, 0x85, 0x6A, 0x4B, 0x28, 0x09, 0xEE, 0xCF, 0xAC, 0x8D,
+		0x53, 0x72, 0x11, 0x30, 0xD7, 0xF6, 0x95, 0xB4, 0x5B, 0x7A, 0x19, 0x38, 0xDF, 0xFE, 0x9D, 0xBC,
+		0xC4, 0xE5, 0x86, 0xA7, 0x40, 0x61, 0x02, 0x23, 0xCC, 0xED, 0x8E, 0xAF, 0x48, 0x69, 0x0A, 0x2B,
+		0xF5, 0xD4, 0xB7, 0x96, 0x71, 0x50, 0x33, 0x12, 0xFD, 0xDC, 0xBF, 0x9E, 0x79, 0x58, 0x3B, 0x1A,
+		0xA6, 0x87, 0xE4, 0xC5, 0x22, 0x03, 0x60, 0x41, 0xAE, 0x8F, 0xEC, 0xCD, 0x2A, 0x0B, 0x68, 0x49,
+		0x97, 0xB6, 0xD5, 0xF4, 0x13, 0x32, 0x51, 0x70, 0x9F, 0xBE, 0xDD, 0xFC, 0x1B, 0x3A, 0x59, 0x78,
+		0x88, 0xA9, 0xCA, 0xEB, 0x0C, 0x2D, 0x4E, 0x6F, 0x80, 0xA1, 0xC2, 0xE3, 0x04, 0x25, 0x46, 0x67,
+		0xB9, 0x98, 0xFB, 0xDA, 0x3D, 0x1C, 0x7F, 0x5E, 0xB1, 0x90, 0xF3, 0xD2, 0x35, 0x14, 0x77, 0x56,
+		0xEA, 0xCB, 0xA8, 0x89, 0x6E, 0x4F, 0x2C, 0x0D, 0xE2, 0xC3, 0xA0, 0x81, 0x66, 0x47, 0x24, 0x05,
+		0xDB, 0xFA, 0x99, 0xB8, 0x5F, 0x7E, 0x1D, 0x3C, 0xD3, 0xF2, 0x91, 0xB0, 0x57, 0x76, 0x15, 0x34,
+		0x4C, 0x6D, 0x0E, 0x2F, 0xC8, 0xE9, 0x8A, 0xAB, 0x44, 0x65, 0x06, 0x27, 0xC0, 0xE1, 0x82, 0xA3,
+		0x7D, 0x5C, 0x3F, 0x1E, 0xF9, 0xD8, 0xBB, 0x9A, 0x75, 0x54, 0x37, 0x16, 0xF1, 0xD0, 0xB3, 0x92,
+		0x2E, 0x0F, 0x6C, 0x4D, 0xAA, 0x8B, 0xE8, 0xC9, 0x26, 0x07, 0x64, 0x45, 0xA2, 0x83, 0xE0, 0xC1,
+		0x1F, 0x3E, 0x5D, 0x7C, 0x9B, 0xBA, 0xD9, 0xF8, 0x17, 0x36, 0x55, 0x74, 0x93, 0xB2, 0xD1, 0xF0,
+	},
+	{
+		0x00, 0x10, 0x20, 0x30, 0x40, 0x50, 0x60, 0x70, 0x81, 0x91, 0xA1, 0xB1, 0xC1, 0xD1, 0xE1, 0xF1,
+		0x12, 0x02, 0x32, 0x22, 0x52, 0x42, 0x72, 0x62, 0x93, 0x83, 0xB3, 0xA3, 0xD3, 0xC3, 0xF3, 0xE3,
+		0x24, 0x34, 0x04, 0x14, 0x64, 0x74, 0x44, 0x54, 0xA5, 0xB5, 0x85, 0x95, 0xE5, 0xF5, 0xC5, 0xD5,
+		0x36, 0x26, 0x16, 0x06, 0x76, 0x66, 0x56, 0x46, 0xB7, 0xA7, 0x97, 0x87, 0xF7, 0xE7, 0xD7, 0xC7,
+		0x48, 0x58, 0x68, 0x78, 0x08, 0x18, 0x28, 0x38, 0xC9, 0xD9, 0xE9, 0xF9, 0x89, 0x99, 0xA9, 0xB9,
+		0x5A, 0x4A, 0x7A, 0x6A, 0x1A, 0x0A, 0x3A, 0x2A, 0xDB, 0xCB, 0xFB, 0xEB, 0x9B, 0x8B, 0xBB, 0xAB,
+		0x6C, 0x7C, 0x4C, 0x5C, 0x2C, 0x3C, 0x0C, 0x1C, 0xED, 0xFD, 0xCD, 0xDD, 0xAD, 0xBD, 0x8D, 0x9D,
+		0x7E, 0x6E, 0x5E, 0x4E, 0x3E, 0x2E, 0x1E, 0x0E, 0xFF, 0xEF, 0xDF, 0xCF, 0xBF, 0xAF, 0x9F, 0x8F,
+		0x91, 0x81, 0xB1, 0xA1, 0xD1, 0xC1, 0xF1, 0xE1, 0x10, 0x00, 0x30, 0x20, 0x50, 0x40, 0x70, 0x60,
+		0x83, 0x93, 0xA3, 0xB3, 0xC3, 0xD3, 0xE3, 0xF3, 0x02, 0x12, 0x22, 0x32, 0x42, 0x52, 0x62, 0x72,
+		0xB5, 0xA5, 0x95, 0x85, 0xF5, 0xE5, 0xD5, 0xC5, 0x34, 0x24, 0x14, 0x04, 0x74, 0x64, 0x54, 0x44,
+		0xA7, 0xB7, 0x87, 0x97, 0xE7, 0xF7, 0xC7, 0xD7, 0x26, 0x36, 0x06, 0x16, 0x66, 0x76, 0x46, 0x56,
+		0xD9, 0xC9, 0xF9, 0xE9, 0x99, 0x89, 0xB9, 0xA9, 0x58, 0x48, 0x78, 0x68, 0x18, 0x08, 0x38, 0x28,
+		0xCB, 0xDB, 0xEB, 0xFB, 0x8B, 0x9B, 0xAB, 0xBB, 0x4A, 0x5A, 0x6A, 0x7A, 0x0A, 0x1A, 0x2A, 0x3A,
+		0xFD, 0xED, 0xDD, 0xCD, 0xBD, 0xAD, 0x9D, 0x8D, 0x7C, 0x6C, 0x5C, 0x4C, 0x3C, 0x2C, 0x1C, 0x0C,
+		0xEF, 0xFF, 0xCF, 0xDF, 0xAF, 0xBF, 0x8F, 0x9F, 0x6E, 0x7E, 0x4E, 0x5E, 0x2E, 0x3E, 0x0E, 0x1E,
+	},
+};
+
+static const uint8_t crc16_modbus_table[2][256] PROGMEM __attribute__((aligned(256))) = {
+	{
+		0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41, 0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40,
+		0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40, 0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41,
+		0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40, 0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41,
+		0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41, 0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40,
+		0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40, 0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41,
+		0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41, 0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40,
+		0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41, 0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40,
+		0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40, 0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41,
+		0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40, 0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41,
+		0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41, 0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40,
+		0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41, 0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40,
+		0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40, 0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41,
+		0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41, 0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40,
+		0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40, 0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41,
+		0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40, 0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41,
+		0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41, 0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40,
+	},
+	{
+		0x00, 0xC0, 0xC1, 0x01, 0xC3, 0x03, 0x02, 0xC2, 0xC6, 0x06, 0x07, 0xC7, 0x05, 0xC5, 0xC4, 0x04,
+		0xCC, 0x0C, 0x0D, 0xCD, 0x0F, 0xCF, 0xCE, 0x0E, 0x0A, 0xCA, 0xCB, 0x0B, 0xC9, 0x09, 0x08, 0xC8,
+		0xD8, 0x18, 0x19, 0xD9, 0x1B, 0xDB, 0xDA, 0x1A, 0x1E, 0xDE, 0xDF, 0x1F, 0xDD, 0x1D, 0x1C, 0xDC,
+		0x14, 0xD4, 0xD5, 0x15, 0xD7, 0x17, 0x16, 0xD6, 0xD2, 0x12, 0x13, 0xD3, 0x11, 0xD1, 0xD0, 0x10,
+		0xF0, 0x30, 0x31, 0xF1, 0x33, 0xF3, 0xF2, 0x32, 0x36, 0xF6, 0xF7, 0x37, 0xF5, 0x35, 0x34, 0xF4,
+		0x3C, 0xFC, 0xFD, 0x3D, 0xFF, 0x3F, 0x3E, 0xFE, 0xFA, 0x3A, 0x3B, 0xFB, 0x39, 0xF9, 0xF8, 0x38,
+		0x28, 0xE8, 0xE9, 0x29, 0xEB, 0x2B, 0x2A, 0xEA, 0xEE, 0x2E, 0x2F, 0xEF, 0x2D, 0xED, 0xEC, 0x2C,
+		0xE4, 0x24, 0x25, 0xE5, 0x27, 0xE7, 0xE6, 0x26, 0x22, 0xE2, 0xE3, 0x23, 0xE1, 0x21, 0x20, 0xE0,
+		0xA0, 0x60, 0x61, 0xA1, 0x63, 0xA3, 0xA2, 0x62, 0x66, 0xA6, 0xA7, 0x67, 0xA5, 0x65, 0x64, 0xA4,
+		0x6C, 0xAC, 0xAD, 0x6D, 0xAF, 0x6F, 0x6E, 0xAE, 0xAA, 0x6A, 0x6B, 0xAB, 0x69, 0xA9, 0xA8, 0x68,
+		0x78, 0xB8, 0xB9, 0x79, 0xBB, 0x7B, 0x7A, 0xBA, 0xBE, 0x7E, 0x7F, 0xBF, 0x7D, 0xBD, 0xBC, 0x7C,
+		0xB4, 0x74, 0x75, 0xB5, 0x77, 0xB7, 0xB6, 0x76, 0x72, 0xB2, 0xB3, 0x73, 0xB1, 0x71, 0x70, 0xB0,
+		0x50, 0x90, 0x91, 0x51, 0x93, 0x53, 0x52, 0x92, 0x96, 0x56, 0x57, 0x97, 0x55, 0x95, 0x94, 0x54,
+		0x9C, 0x5C, 0x5D, 0x9D, 0x5F, 0x9F, 0x9E, 0x5E, 0x5A, 0x9A, 0x9B, 0x5B, 0x99, 0x59, 0x58, 0x98,
+		0x88, 0x48, 0x49, 0x89, 0x4B, 0x8B, 0x8A, 0x4A, 0x4E, 0x8E, 0x8F, 0x4F, 0x8D, 0x4D, 0x4C, 0x8C,
+		0x44, 0x84, 0x85, 0x45, 0x87, 0x47, 0x46, 0x86, 0x82, 0x42, 0x43, 0x83, 0x41, 0x81, 0x80, 0x40,
+	},
+};
+
+static const uint8_t crc32_table[4][256] PROGMEM __attribute__((aligned(256))) = {
+	{
+		0x00, 0x96, 0x2C, 0xBA, 0x19, 0x8F, 0x35, 0xA3, 0x32, 0xA4, 0x1E, 0x88, 0x2B, 0xBD, 0x07, 0x91,
+		0x64, 0xF2, 0x48, 0xDE, 0x7D, 0xEB, 0x51, 0xC7, 0x56, 0xC0, 0x7A, 0xEC, 0x4F, 0xD9, 0x63, 0xF5,
+		0xC8, 0x5E, 0xE4, 0x72, 0xD1, 0x47, 0xFD, 0x6B, 0xFA, 0x6C, 0xD6, 0x40, 0xE3, 0x75, 0xCF, 0x59,
+		0xAC, 0x3A, 0x80, 0x16, 0xB5, 0x23, 0x99, 0x0F, 0x9E, 0x08, 0xB2, 0x24, 0x87, 0x11, 0xAB, 0x3D,
+		0x90, 0x06, 0xBC, 0x2A, 0x89, 0x1F, 0xA5, 0x33, 0xA2, 0x34, 0x8E, 0x18, 0xBB, 0x2D, 0x97, 0x01,
+		0xF4, 0x62, 0xD8, 0x4E, 0xED, 0x7B, 0xC1, 0x57, 0xC6, 0x50, 0xEA, 0x7C, 0xDF, 0x49, 0xF3, 0x65,
+		0x58, 0xCE, 0x74, 0xE2, 0x41, 0xD7, 0x6D, 0xFB, 0x6A, 0xFC, 0x46, 0xD0, 0x73, 0xE5, 0x5F, 0xC9,
+		0x3C, 0xAA, 0x10, 0x86, 0x25, 0xB3, 0x09, 0x9F, 0x0E, 0x98, 0x22, 0xB4, 0x17, 0x81, 0x3B, 0xAD,
+		0x20, 0xB6, 0x0C, 0x9A, 0x39, 0xAF, 0x15, 0x83, 0x12, 0x84, 0x3E, 0xA8, 0x0B, 0x9D, 0x27, 0xB1,
+		0x44, 0xD2, 0x68, 0xFE, 0x5D, 0xCB, 0x71, 0xE7, 0x76, 0xE0, 0x5A, 0xCC, 0x6F, 0xF9, 0x43, 0xD5,
+		0xE8, 0x7E, 0xC4, 0x52, 0xF1, 0x67, 0xDD, 0x4B, 0xDA, 0x4C, 0xF6, 0x60, 0xC3, 0x55, 0xEF, 0x79,
+		0x8C, 0x1A, 0xA0, 0x36, 0x95, 0x03, 0xB9, 0x2F, 0xBE, 0x28, 0x92, 0x04, 0xA7, 0x31, 0x8B, 0x1D,
+		0xB0, 0x26, 0x9C, 0x0A, 0xA9, 0x3F, 0x85, 0x13, 0x82, 0x14, 0xAE, 0x38, 0x9B, 0x0D, 0xB7, 0x21,
+		0xD4, 0x42, 0xF8, 0x6E, 0xCD, 0x5B, 0xE1, 0x77, 0xE6, 0x70, 0xCA, 0x5C, 0xFF, 0x69, 0xD3, 0x45,
+		0x78, 0xEE, 0x54, 0xC2, 0x61, 0xF7, 0x4D, 0xDB, 0x4A, 0xDC, 0x66, 0xF0, 0x53, 0xC5, 0x7F, 0xE9,
+		0x1C, 0x8A, 0x30, 0xA6, 0x05, 0x93, 0x29, 0xBF, 0x2E, 0xB8, 0x02, 0x94, 0x37, 0xA1, 0x1B, 0x8D,
+	},
+	{
+		0x00, 0x30, 0x61, 0x51, 0xC4, 0xF4, 0xA5, 0x95, 0x88, 0xB8, 0xE9, 0xD9, 0x4C, 0x7C, 0x2D, 0x1D,
+		0x10, 0x20, 0x71, 0x41, 0xD4, 0xE4, 0xB5, 0x85, 0x98, 0xA8, 0xF9, 0xC9, 0x5C, 0x6C, 0x3D, 0x0D,
+		0x20, 0x10, 0x41, 0x71, 0xE4, 0xD4, 0x85, 0xB5, 0xA8, 0x98, 0xC9, 0xF9, 0x6C, 0x5C, 0x0D, 0x3D,
+		0x30, 0x00, 0x51, 0x61, 0xF4, 0xC4, 0x95, 0xA5, 0xB8, 0x88, 0xD9, 0xE9, 0x7C, 0x4C, 0x1D, 0x2D,
+		0x41, 0x71, 0x20, 0x10, 0x85, 0xB5, 0xE4, 0xD4, 0xC9, 0xF9, 0xA8, 0x98, 0x0D, 0x3D, 0x6C, 0x5C,
+		0x51, 0x61, 0x30, 0x00, 0x95, 0xA5, 0xF4, 0xC4, 0xD9, 0xE9, 0xB8, 0x88, 0x1D, 0x2D, 0x7C, 0x4C,
+		0x61, 0x51, 0x00, 0x30, 0xA5, 0x95, 0xC4, 0xF4, 0xE9, 0xD9, 0x88, 0xB8, 0x2D, 0x1D, 0x4C, 0x7C,
+		0x71, 0x41, 0x10, 0x20, 0xB5, 0x85, 0xD4, 0xE4, 0xF9, 0xC9, 0x98, 0xA8, 0x3D, 0x0D, 0x5C, 0x6C,
+		0x83, 0xB3, 0xE2, 0xD2, 0x47, 0x77, 0x26, 0x16, 0x0B, 0x3B, 0x6A, 0x5A, 0xCF, 0xFF, 0xAE, 0x9E,
+		0x93, 0xA3, 0xF2, 0xC2, 0x57, 0x67, 0x36, 0x06, 0x1B, 0x2B, 0x7A, 0x4A, 0xDF, 0xEF, 0xBE, 0x8E,
+		0xA3, 0x93, 0xC2, 0xF2, 0x67, 0x57, 0x06, 0x36, 0x2B, 0x1B, 0x4A, 0x7A, 0xEF, 0xDF, 0x8E, 0xBE,
+		0xB3, 0x83, 0xD2, 0xE2, 0x77, 0x47, 0x16, 0x26, 0x3B, 0x0B, 0x5A, 0x6A, 0xFF, 0xCF, 0x9E, 0xAE,
+		0xC2, 0xF2, 0xA3, 0x93, 0x06, 0x36, 0x67, 0x57, 0x4A, 0x7A, 0x2B, 0x1B, 0x8E, 0xBE, 0xEF, 0xDF,
+		0xD2, 0xE2, 0xB3, 0x83, 0x16, 0x26, 0x77, 0x47, 0x5A, 0x6A, 0x3B, 0x0B, 0x9E, 0xAE, 0xFF, 0xCF,
+		0xE2, 0xD2, 0x83, 0xB3, 0x26, 0x16, 0x47, 0x77, 0x6A, 0x5A, 0x0B, 0x3B, 0xAE, 0x9E, 0xCF, 0xFF,
+		0xF2, 0xC2, 0x93, 0xA3, 0x36, 0x06, 0x57, 0x67, 0x7A, 0x4A, 0x1B, 0x2B, 0xBE, 0x8E, 0xDF, 0xEF,
+	},
+	{
+		0x00, 0x07, 0x0E, 0x09, 0x6D, 0x6A, 0x63, 0x64, 0xDB, 0xDC, 0xD5, 0xD2, 0xB6, 0xB1, 0xB8, 0xBF,
+		0xB7, 0xB0, 0xB9, 0xBE, 0xDA, 0xDD, 0xD4, 0xD3, 0x6C, 0x6B, 0x62, 0x65, 0x01, 0x06, 0x0F, 0x08,
+		0x6E, 0x69, 0x60, 0x67, 0x03, 0x04, 0x0D, 0x0A, 0xB5, 0xB2, 0xBB, 0xBC, 0xD8, 0xDF, 0xD6, 0xD1,
+		0xD9, 0xDE, 0xD7, 0xD0, 0xB4, 0xB3, 0xBA, 0xBD, 0x02, 0x05, 0x0C, 0x0B, 0x6F, 0x68, 0x61, 0x66,
+		0xDC, 0xDB, 0xD2, 0xD5, 0xB1, 0xB6, 0xBF, 0xB8, 0x07, 0x00, 0x09, 0x0E, 0x6A, 0x6D, 0x64, 0x63,
+		0x6B, 0x6C, 0x65, 0x62, 0x06, 0x01, 0x08, 0x0F, 0xB0, 0xB7, 0xBE, 0xB9, 0xDD, 0xDA, 0xD3, 0xD4,
+		0xB2, 0xB5, 0xBC, 0xBB, 0xDF, 0xD8, 0xD1, 0xD6, 0x69, 0x6E, 0x67, 0x60, 0x04, 0x03, 0x0A, 0x0D,
+		0x05, 0x02, 0x0B, 0x0C, 0x68, 0x6F, 0x66, 0x61, 0xDE, 0xD9, 0xD0, 0xD7, 0xB3, 0xB4, 0xBD, 0xBA,
+		0xB8, 0xBF, 0xB6, 0xB1, 0xD5, 0xD2, 0xDB, 0xDC, 0x63, 0x64, 0x6D, 0x6A, 0x0E, 0x09, 0x00, 0x07,
+		0x0F, 0x08, 0x01, 0x06, 0x62, 0x65, 0x6C, 0x6B, 0xD4, 0xD3, 0xDA, 0xDD, 0xB9, 0xBE, 0xB7, 0xB0,
+		0xD6, 0xD1, 0xD8, 0xDF, 0xBB, 0xBC, 0xB5, 0xB2, 0x0D, 0x0A, 0x03, 0x04, 0x60, 0x67, 0x6E, 0x69,
+		0x61, 0x66, 0x6F, 0x68, 0x0C, 0x0B, 0x02, 0x05, 0xBA, 0xBD, 0xB4, 0xB3, 0xD7, 0xD0, 0xD9, 0xDE,
+		0x64, 0x63, 0x6A, 0x6D, 0x09, 0x0E, 0x07, 0x00, 0xBF, 0xB8, 0xB1, 0xB6, 0xD2, 0xD5, 0xDC, 0xDB,
+		0xD3, 0xD4, 0xDD, 0xDA, 0xBE, 0xB9, 0xB0, 0xB7, 0x08, 0x0F, 0x06, 0x01, 0x65, 0x62, 0x6B, 0x6C,
+		0x0A, 0x0D, 0x04, 0x03, 0x67, 0x60, 0x69, 0x6E, 0xD1, 0xD6, 0xDF, 0xD8, 0xBC, 0xBB, 0xB2, 0xB5,
+		0xBD, 0xBA, 0xB3, 0xB4, 0xD0, 0xD7, 0xDE, 0xD9, 0x66, 0x61, 0x68, 0x6F, 0x0B, 0x0C, 0x05, 0x02,
+	},
+	{
+		0x00, 0x77, 0xEE, 0x99, 0x07, 0x70, 0xE9, 0x9E, 0x0E, 0x79, 0xE0, 0x97, 0x09, 0x7E, 0xE7, 0x90,
+		0x1D, 0x6A, 0xF3, 0x84, 0x1A, 0x6D, 0xF4, 0x83, 0x13, 0x64, 0xFD, 0x8A, 0x14, 0x63, 0xFA, 0x8D,
+		0x3B, 0x4C, 0xD5, 0xA2, 0x3C, 0x4B, 0xD2, 0xA5, 0x35, 0x42, 0xDB, 0xAC, 0x32, 0x45, 0xDC, 0xAB,
+		0x26, 0x51, 0xC8, 0xBF, 0x21, 0x56, 0xCF, 0xB8, 0x28, 0x5F, 0xC6, 0xB1, 0x2F, 0x58, 0xC1, 0xB6,
+		0x76, 0x01, 0x98, 0xEF, 0x71, 0x06, 0x9F, 0xE8, 0x78, 0x0F, 0x96, 0xE1, 0x7F, 0x08, 0x91, 0xE6,
+		0x6B, 0x1C, 0x85, 0xF2, 0x6C, 0x1B, 0x82, 0xF5, 0x65, 0x12, 0x8B, 0xFC, 0x62, 0x15, 0x8C, 0xFB,
+		0x4D, 0x3A, 0xA3, 0xD4, 0x4A, 0x3D, 0xA4, 0xD3, 0x43, 0x34, 0xAD, 0xDA, 0x44, 0x33, 0xAA, 0xDD,
+		0x50, 0x27, 0xBE, 0xC9, 0x57, 0x20, 0xB9, 0xCE, 0x5E, 0x29, 0xB0, 0xC7, 0x59, 0x2E, 0xB7, 0xC0,
+		0xED, 0x9A, 0x03, 0x74, 0xEA, 0x9D, 0x04, 0x73, 0xE3, 0x94, 0x0D, 0x7A, 0xE4, 0x93, 0x0A, 0x7D,
+		0xF0, 0x87, 0x1E, 0x69, 0xF7, 0x80, 0x19, 0x6E, 0xFE, 0x89, 0x10, 0x67, 0xF9, 0x8E, 0x17, 0x60,
+		0xD6, 0xA1, 0x38, 0x4F, 0xD1, 0xA6, 0x3F, 0x48, 0xD8, 0xAF, 0x36, 0x41, 0xDF, 0xA8, 0x31, 0x46,
+		0xCB, 0xBC, 0x25, 0x52, 0xCC, 0xBB, 0x22, 0x55, 0xC5, 0xB2, 0x2B, 0x5C, 0xC2, 0xB5, 0x2C, 0x5B,
+		0x9B, 0xEC, 0x75, 0x02, 0x9C, 0xEB, 0x72, 0x05, 0x95, 0xE2, 0x7B, 0x0C, 0x92, 0xE5, 0x7C, 0x0B,
+		0x86, 0xF1, 0x68, 0x1F, 0x81, 0xF6, 0x6F, 0x18, 0x88, 0xFF, 0x66, 0x11, 0x8F, 0xF8, 0x61, 0x16,
+		0xA0, 0xD7, 0x4E, 0x39, 0xA7, 0xD0, 0x49, 0x3E, 0xAE, 0xD9, 0x40, 0x37, 0xA9, 0xDE, 0x47, 0x30,
+		0xBD, 0xCA, 0x53, 0x24, 0xBA, 0xCD, 0x54, 0x23, 0xB3, 0xC4, 0x5D, 0x2A, 0xB4, 0xC3, 0x5A, 0x2D,
+	},
+};
+
+static const uint16_t crc16_ccitt_nibbles[16] PROGMEM = {
+	0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+	0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+static const uint16_t crc16_modbus_nibbles[16] PROGMEM = {
+	0x0000, 0xCC01, 0xD801, 0x1400, 0xF001, 0x3C00, 0x2800, 0xE401,
+	0xA001, 0x6C00, 0x7800, 0xB401, 0x5000, 0x9C01, 0x8801, 0x4400
+};
+
+static const uint32_t crc32_nibbles[16] PROGMEM = {
+	0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+	0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+#define crc_byte(t, b, i) pgm_read_byte(&(t)[b][i])
+
+uint16_t crc16_ccitt_nibble(uint16_t crc, const void *data, int n)
+{
+	const uint8_t *p = (const uint8_t *)data;
+	while (n-->0)
+	{
+		crc ^= (uint16_t)*p++<<8;
+		crc = crc<<4 ^ pgm_read_word(&crc16_ccitt_nibbles[crc>>12]);
+		crc = crc<<4 ^ pgm_read_word(&crc16_ccitt_nibbles[crc>>12]);
+	}
+	return crc;
+}
+
+uint16_t crc16_modbus_nibble(uint16_t crc, const void *data, int n)
+{
+	const uint8_t *p = (const uint8_t *)data;
+	while (n-->0)
+	{
+		crc ^= *p++;
+		crc = crc>>4 ^ pgm_read_word(&crc16_modbus_nibbles[crc&0xF]);
+		crc = crc>>4 ^ pgm_read_word(&crc16_modbus_nibbles[crc&0xF]);
+	}
+	return crc;
+}
+
+uint32_t crc32_nibble(uint32_t crc, const void *data, int n)
+{
+	const uint8_t *p = (const uint8_t *)data;
+	crc = ~crc;
+	while (n-->0)
+	{
+		crc ^= *p++;
+		crc = crc>>4 ^ pgm_read_dword(&crc32_nibbles[crc&0xF]);
+		crc = crc>>4 ^ pgm_read_dword(&crc32_nibbles[crc&0xF]);
+	}
+	return ~crc;
+}
+
+#if defined(__x86_64__) && defined(LILLIB_CFG_CRC_SLICE8) && !defined(LILLIB_CFG_CRC_NIBBLE)
+// Slice by 8: table k gives the effect of a byte followed by k zero bytes, so the CRC of 8 bytes is the XOR of
+// a lookup for each (with the CRC so far XORed into the first 2 or 4).  Made from the byte tables by a
+// constructor, before main, so there's no first-use check to race (a thread could see the tables part made).
+static uint16_t crc16_ccitt_slices[8][256], crc16_modbus_slices[8][256];
+static uint32_t crc32_slices[8][256];
+
+static void crc16_slices_init(uint16_t slices[8][256], const uint8_t table[2][256], uint8_t msb_first)
+{
+	int i, k;
+	uint16_t v;
+	for (i=0; i<256; i++) slices[0][i] = table[0][i] | table[1][i]<<8;
+	for (k=1; k<8; k++)
+	{
+		for (i=0; i<256; i++)
+		{
+			v = slices[k-1][i];
+			slices[k][i] = (msb_first ? (uint16_t)(v<<8) ^ slices[0][v>>8] : v>>8 ^ slices[0][v&0xFF]);
+		}
+	}
+}
+
+static void __attribute__((constructor)) crc_slices_init(void)
+{
+	uint32_t (*t)[256] = crc32_slices;
+	int i, k;
+	crc16_slices_init(crc16_ccitt_slices, crc16_ccitt_table, 1);
+	crc16_slices_init(crc16_modbus_slices, crc16_modbus_table, 0);
+	for (i=0; i<256; i++) t[0][i] = crc32_table[0][i] | crc32_table[1][i]<<8 | crc32_table[2][i]<<16 | (uint32_t)crc32_table[3][i]<<24;
+	for (k=1; k<8; k++) for (i=0; i<256; i++) t[k][i] = t[k-1][i]>>8 ^ t[0][t[k-1][i]&0xFF];
+}
+
+static uint16_t crc16_ccitt_slice8(uint16_t crc, const uint8_t **data, int *n)
+{
+	const uint8_t *p = *data;
+	uint16_t (*t)[256] = crc16_ccitt_slices;
+	for ( ; *n>=8; *n-=8, p+=8)
+	{
+		crc = t[7][p[0]^crc>>8] ^ t[6][p[1]^(crc&0xFF)] ^ t[5][p[2]] ^ t[4][p[3]] ^
+		      t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+	}
+	*data = p;
+	return crc;
+}
+
+static uint16_t crc16_modbus_slice8(uint16_t crc, const uint8_t **data, int *n)
+{
+	const uint8_t *p = *data;
+	uint16_t (*t)[256] = crc16_modbus_slices;
+	for ( ; *n>=8; *n-=8, p+=8)
+	{
+		crc = t[7][p[0]^(crc&0xFF)] ^ t[6][p[1]^crc>>8] ^ t[5][p[2]] ^ t[4][p[3]] ^
+		      t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+	}
+	*data = p;
+	return crc;
+}
+
+static uint32_t crc32_slice8(uint32_t crc, const uint8_t **data, int *n)
+{
+	const uint8_t *p = *data;
+	uint32_t (*t)[256] = crc32_slices, a, b;
+	for ( ; *n>=8; *n-=8, p+=8)
+	{
+		__builtin_memcpy(&a, p, 4);
+		__builtin_memcpy(&b, p+4, 4);
+		a ^= crc;
+		crc = t[7][a&0xFF] ^ t[6][a>>8&0xFF] ^ t[5][a>>16&0xFF] ^ t[4][a>>24] ^
+		      t[3][b&0xFF] ^ t[2][b>>8&0xFF] ^ t[1][b>>16&0xFF] ^ t[0][b>>24];
+	}
+	*data = p;
+	return crc;
+}
+#endif
+
+#if defined(__AVR__) && !defined(LILLIB_CFG_CRC_NIBBLE)
+// A byte at a time: ld the byte, XOR it into the CRC for the table index in ZL, and lpm each table's byte (ZH
+// stepping through the tables), ~17 cycles a byte for CRC-16 and ~27 for CRC-32.  n>0.
+#define CRC_AVR_LOOP(body)              \
+		"   rjmp  2f              \n"   \
+		"1: ld    %[t], X+        \n"   \
+		body                            \
+		"2: subi  %A[n], 1        \n"   \
+		"   sbci  %B[n], 0        \n"   \
+		"   brcc  1b              \n"
+#endif
+
+uint16_t crc16_ccitt_update(uint16_t crc, const void *data, int n)
+{
+	const uint8_t *p = (const uint8_t *)data;
+#if defined(LILLIB_CFG_CRC_NIBBLE)
+	return crc16_ccitt_nibble(crc, data, n);
+#elif defined(__AVR__)
+	const uint8_t *z = crc16_ccitt_table[0];
+	uint8_t t;
+	if (n<=0) return crc;
+	// The new CRC is crc<<8 ^ table[crc>>8 ^ byte]
+	__asm__ (
+		CRC_AVR_LOOP(
+		"   eor   %[t], %B[crc]   \n"
+		"   mov   %A[z], %[t]     \n"
+		"   inc   %B[z]           \n"
+		"   lpm   %[t], Z         \n"
+		"   eor   %[t], %A[crc]   \n"
+		"   mov   %B[crc], %[t]   \n"
+		"   dec   %B[z]           \n"
+		"   lpm   %A[crc], Z      \n")
+		: [crc] "+r" (crc), [p] "+x" (p), [z] "+z" (z), [n] "+d" (n), [t] "=&r" (t)
+		:
+		: "memory"
+	);
+	return crc;
+#else
+	uint8_t i;
+#ifdef LILLIB_CFG_CRC_SLICE8
+	crc = crc16_ccitt_slice8(crc, &p, &n);
+#endif
+	for ( ; n>0; n--) i = crc>>8 ^ *p++, crc = crc<<8 ^ (crc_byte(crc16_ccitt_table, 0, i) | crc_byte(crc16_ccitt_table, 1, i)<<8);
+	return crc;
+#endif
+}
+
+uint16_t crc16_modbus_update(uint16_t crc, const void *data, int n)
+{
+	const uint8_t *p = (const uint8_t *)data;
+#if defined(LILLIB_CFG_CRC_NIBBLE)
+	return crc16_modbus_nibble(crc, data, n);
+#elif defined(__AVR__)
+	const uint8_t *z = crc16_modbus_table[0];
+	uint8_t t;
+	if (n<=0) return crc;
+	// The new CRC is crc>>8 ^ table[crc&0xFF ^ byte]
+	__asm__ (
+		CRC_AVR_LOOP(
+		"   eor   %[t], %A[crc]   \n"
+		"   mov   %A[z], %[t]     \n"
+		"   lpm   %A[crc], Z      \n"
+		"   eor   %A[crc], %B[crc]\n"
+		"   inc   %B[z]           \n"
+		"   lpm   %B[crc], Z      \n"
+		"   dec   %B[z]           \n")
+		: [crc] "+r" (crc), [p] "+x" (p), [z] "+z" (z), [n] "+d" (n), [t] "=&r" (t)
+		:
+		: "memory"
+	);
+	return crc;
+#else
+	uint8_t i;
+#ifdef LILLIB_CFG_CRC_SLICE8
+	crc = crc16_modbus_slice8(crc, &p, &n);
+#endif
+	for ( ; n>0; n--) i = crc ^ *p++, crc = crc>>8 ^ (crc_byte(crc16_modbus_table, 0, i) | crc_byte(crc16_modbus_table, 1, i)<<8);
+	return crc;
+#endif
+}
+
+uint32_t crc32_update(uint32_t crc, const void *data, int n)
+{
+	const uint8_t *p = (const uint8_t *)data;
+#if defined(LILLIB_CFG_CRC_NIBBLE)
+	return crc32_nibble(crc, data, n);
+#elif defined(__AVR__)
+	const uint8_t *z = crc32_table[0];
+	uint8_t t;
+	if (n<=0) return crc;
+	crc = ~crc;
+	// The new CRC is crc>>8 ^ table[crc&0xFF ^ byte]
+	__asm__ (
+		CRC_AVR_LOOP(
+		"   eor   %[t], %A[crc]   \n"
+		"   mov   %A[z], %[t]     \n"
+		"   lpm   %A[crc], Z      \n"
+		"   eor   %A[crc], %B[crc]\n"
+		"   inc   %B[z]           \n"
+		"   lpm   %B[crc], Z      \n"
+		"   eor   %B[crc], %C[crc]\n"
+		"   inc   %B[z]           \n"
+		"   lpm   %C[crc], Z      \n"
+		"   eor   %C[crc], %D[crc]\n"
+		"   inc   %B[z]           \n"
+		"   lpm   %D[crc], Z      \n"
+		"   subi  %B[z], 3        \n")
+		: [crc] "+r" (crc), [p] "+x" (p), [z] "+z" (z), [n] "+d" (n), [t] "=&r" (t)
+		:
+		: "memory"
+	);
+	return ~crc;
+#else
+	uint8_t i;
+	crc = ~crc;
+#ifdef LILLIB_CFG_CRC_SLICE8
+	crc = crc32_slice8(crc, &p, &n);
+#endif
+	for ( ; n>0; n--)
+	{
+		i = crc ^ *p++;
+		crc = crc>>8 ^ (crc_byte(crc32_table, 0, i) | crc_byte(crc32_table, 1, i)<<8 |
+		                (uint32_t)crc_byte(crc32_table, 2, i)<<16 | (uint32_t)crc_byte(crc32_table, 3, i)<<24);
+	}
+	return ~crc;
+#endif
+}
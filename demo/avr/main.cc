@@ -487,9 +487,7 @@ void AHT10_demo()
 		uint32_t xvh = (((uint32_t)data[1])<<12)|(((uint32_t)data[2])<<4)|(((uint32_t)data[3])>>4);
 		uint32_t xvt = (((uint32_t)(data[3]&0xF))<<16)|(((uint32_t)data[4])<<8)|(((uint32_t)data[5]));
 		
-		uint16_t vh = xvh >> 4;
-		uint16_t vt = xvt >> 4;
-		com_printf("READ (r=%i,%i) state=0x%02X,  %i, %i\n", r1, r2, state, vh, vt);
+		com_printf("READ (r=%i,%i) state=0x%02X,  %lu, %lu\n", r1, r2, state, xvh, xvt);
 
 		delay(100);
 	}
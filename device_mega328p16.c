@@ -57,6 +57,7 @@ static volatile uint8_t com_rxbuf_r, com_rxbuf_w;
 static volatile uint8_t com_txbuf_r, com_txbuf_w;
 static volatile char com_rxbuf[COM_RXBUF_SIZE+1];
 static volatile char com_txbuf[COM_TXBUF_SIZE+1];
+static volatile uint8_t com_tx_mask = 0x7F; // 0xFF in binary mode, applied as bytes leave the ring
 
 ISR(USART_RX_vect)
 {
@@ -72,7 +73,7 @@ ISR(USART_UDRE_vect)
 {
 	if (com_txbuf_r!=com_txbuf_w)
 	{
-		UDR0 = (uint8_t)(com_txbuf[com_txbuf_r]&0x7F);
+		UDR0 = (uint8_t)(com_txbuf[com_txbuf_r]&com_tx_mask);
 		com_txbuf_r = (uint8_t)((com_txbuf_r+1)&COM_TXBUF_SIZE);
 	}
 	else UCSR0B = 0x98; // Clear UDRIE
@@ -88,6 +89,15 @@ void com_init()
 	UCSR0C = 0x06;
 }
 
+// The mask is applied by the UDRE ISR, so bytes already in the ring would go out in the new mode.  Waits for
+// the ring to drain first: by then the ISR has moved every queued byte to UDR0 under the old mask, so there's
+// no need to wait for TXC as well.
+void com_set_binary(uint8_t on)
+{
+	while (com_txbuf_r!=com_txbuf_w);
+	com_tx_mask = (on ? 0xFF : 0x7F);
+}
+
 // TODO: Most of the 'device' things really just need to access the buffer... can I fix that?
 uint8_t com_poll()
 {
@@ -114,4 +124,60 @@ void com_putc(char c)
 	UCSR0B = 0xB8; // Set UDRIE
 }
 
+// Copies spans straight into the TX ring, a contiguous run of free space at a time.  The ring is only
+// kicked (UDRIE set) if it fills up, so callers must set UDRIE when done.
+static void com_tx_write(const char *s, int n, char c)
+{
+	// Plain stores for the copies, as the ISR won't read a byte until com_txbuf_w passes it.  That needs the
+	// stores done before com_txbuf_w moves, hence the compiler barriers.
+	char *buf = (char *)com_txbuf;
+	uint8_t w = com_txbuf_w;
+	uint8_t k, room;
+	while (n>0)
+	{
+		room = (uint8_t)((com_txbuf_r-w-1)&COM_TXBUF_SIZE);
+		if (!room)
+		{
+			__asm__ __volatile__("" ::: "memory");
+			com_txbuf_w = w;
+			UCSR0B = 0xB8; // Set UDRIE so it drains
+			while (!(uint8_t)((com_txbuf_r-w-1)&COM_TXBUF_SIZE));
+			continue;
+		}
+		k = COM_TXBUF_SIZE+1-w; // To the end of the buffer
+		if (k>room) k = room;
+		if (k>n)    k = n;
+		n -= k;
+		if (s) qmemcpy(buf+w, s, k), s += k;
+		else   qmemset(buf+w, c, k);
+		w = (w+k)&COM_TXBUF_SIZE;
+	}
+	__asm__ __volatile__("" ::: "memory");
+	com_txbuf_w = w;
+}
+
+void com_write(const char *data, int n)
+{
+	com_tx_write(data, n, 0);
+	UCSR0B = 0xB8; // Set UDRIE
+}
+
+void com_printf(const char *fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	strf_print_bulk(com_tx_write, fmt, args);
+	va_end(args);
+	UCSR0B = 0xB8; // Set UDRIE
+}
+
+void com_printf_P(const char *fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	strf_print_bulk_P(com_tx_write, fmt, args);
+	va_end(args);
+	UCSR0B = 0xB8; // Set UDRIE
+}
+
 #endif // __AVR__
@@ -15,6 +15,8 @@ typedef signed int int32_t;
 typedef unsigned char uint8_t;
 typedef unsigned short uint16_t;
 typedef unsigned int uint32_t;
+typedef signed long int64_t;
+typedef unsigned long uint64_t;
 #define VA_LIST_PTR(v) ((va_list *)(v))
 #elif defined __arm__
 typedef signed char int8_t;
@@ -23,6 +25,8 @@ typedef signed long int32_t;
 typedef unsigned char uint8_t;
 typedef unsigned short uint16_t;
 typedef unsigned long uint32_t;
+typedef signed long long int64_t;
+typedef unsigned long long uint64_t;
 #define VA_LIST_PTR(v) (&(v))
 #elif defined __AVR__
 typedef signed char int8_t;
@@ -31,6 +35,8 @@ typedef signed long int int32_t;
 typedef unsigned char uint8_t;
 typedef unsigned int uint16_t;
 typedef unsigned long int uint32_t;
+typedef signed long long int int64_t;
+typedef unsigned long long int uint64_t;
 #define VA_LIST_PTR(v) (&(v))
 #else
 #error Unknown ARCH
@@ -40,6 +46,17 @@ typedef unsigned long int uint32_t;
 #define NULL ((void *)0)
 #endif
 
+// Flash data.  Only the AVR has a separate program space, elsewhere these are plain memory accesses
+#ifdef __AVR__
+#include <avr/pgmspace.h>
+#else
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define pgm_read_word(p) (*(const uint16_t *)(p))
+#define pgm_read_dword(p) (*(const uint32_t *)(p))
+#endif
+
 //Config
 #define LILLIB_CFG_AES_AVR_ASM
 #define LILLIB_CFG_AES_AVR_ASM_TEST
@@ -48,11 +65,46 @@ typedef unsigned long int uint32_t;
 // #define LILLIB_CFG_AES_DECRYPT
 // #define LILLIB_CFG_AES_128
 // #define LILLIB_CFG_AES_256
+// %ll support in the formatters.  It costs 32 bytes of formatter stack and pulls in 64-bit division,
+// so it is left off on the AVR (where %l is already 32 bits)
+#ifndef __AVR__
+#define LILLIB_CFG_CONV_LONGLONG
+#endif
+// %f/%e/%g support in the formatters (without libm), otherwise they print "<float?>".  It links strf_ftoa
+// and its 32 bit multiply chains into anything using the formatters, so it is left off on the AVR too (%k/%K
+// print Q16.16 fixed point without it)
+#ifndef __AVR__
+#define LILLIB_CFG_CONV_FLOAT
+#endif
+// Widest com_hexdump line, which sets its stack use (HEXDUMP_LINE_SIZE + width for streaming)
+#define LILLIB_CFG_HEXDUMP_MAX_WIDTH 16
+// SSSE3/AVX2 base64 on x86_64 hosts (see coding_x86.c)
+#ifdef __x86_64__
+#define LILLIB_CFG_CODING_X86_SIMD
+#endif
+// CRCs a nibble at a time with 16 entry tables, instead of a byte at a time with 256 entry ones (see crc.c)
+// #define LILLIB_CFG_CRC_NIBBLE
+// Slice by 8 CRCs on x86_64 hosts, with 16K of tables made at startup
+#ifdef __x86_64__
+#define LILLIB_CFG_CRC_SLICE8
+#endif
+// LZSS window of 2^bits bytes (max 12), the RAM each compressor/decompressor needs, and bits of match length.
+// Both ends must agree (see lzss.c)
+#define LILLIB_CFG_LZSS_WINDOW_BITS 8
+#define LILLIB_CFG_LZSS_LENGTH_BITS 4
+// Ids below this have their last value remembered for telemetry deltas, 4 bytes each (see tlm.c)
+#define LILLIB_CFG_TLM_DELTA_IDS 16
+// Largest LOG() record payload (fmt address and arguments), max 111
+#define LILLIB_CFG_LOG_RECORD_SIZE 32
 
 //Flags/constants
 #define ITOA2_UCASE    0x01  // Upper case letters for radix>10
 #define ITOA2_SIGNED   0x02  // Number is signed
 #define ITOA2_NOSIGN   0x04  // Supress displaying sign
+#define HEXDUMP_ADDR(digits)  (digits)  // Address column of digits hex digits (0 for none), up to 8 (more give 8)
+#define HEXDUMP_ADDR_MASK     0x0F
+#define HEXDUMP_ASCII         0x10      // Add an ASCII column
+#define HEXDUMP_LINE_SIZE(width)  (5*(width)+14)
 
 //Functions
 void udelay(unsigned int us);
@@ -62,17 +114,53 @@ void sleep(unsigned int ms);
 #endif
 
 int qstrlen(const char *str);
+int qstrlen_P(const char *str);
 char qstrcmp(const char *a, const char *b);
+char *qstrchr(const char *str, char c);
+char *qstrchrnul(const char *str, char c);
+void *qmemcpy(void *dst, const void *src, int n);
+void *qmemset(void *dst, char c, int n);
+int qmemcmp(const void *a, const void *b, int n);
+void *qmemchr(const void *mem, char c, int n);
+
+typedef struct
+{
+	char *buf;
+	int size;   // Of buf, including the NUL
+	int length; // Of everything appended, even what didn't fit
+} strb;
+#define strb_truncated(b) ((b)->length >= (b)->size)
+void strb_init(strb *b, char *buf, int size);
+strb *strb_append(strb *b, const char *s, int n, char c);
+strb *strb_append_str(strb *b, const char *s);
+strb *strb_append_str_P(strb *b, const char *s);
+strb *strb_append_char(strb *b, char c);
+strb *strb_append_int(strb *b, int32_t v, char radix, int8_t width, char fill);
+strb *strb_append_hex(strb *b, uint32_t v, uint8_t digits);
+strb *strb_append_fix(strb *b, int32_t v, uint8_t decimals);
 
 typedef void (*strf_putc)(char c);
-void qsprintf(char *buf, int size, const char *fmt, ...);
+typedef void (*strf_write)(const char *s, int n, char c); // n chars from s, or if s==NULL, n copies of c
+int qsprintf(char *buf, int size, const char *fmt, ...);
+int qsprintf_P(char *buf, int size, const char *fmt, ...);
 char *itoa2(char *rbuf, unsigned int v, char radix, uint8_t flags);
+char *itoa2_8(char *rbuf, uint8_t v, char radix, uint8_t flags);
+char *itoa2_32(char *rbuf, uint32_t v, char radix, uint8_t flags);
+char *itoa2_64(char *rbuf, uint64_t v, char radix, uint8_t flags);
 int qstrtol(const char *str, const char **end, char radix);
 int strtol_b10(const char *str, const char **end);
 int strtol_b10u(const char *str, const char **end);
 int strtol_b10u_micro(const char *str, const char **end);
+int32_t strtofix(const char *str, const char **end, uint8_t decimals);
+int16_t strtofix16(const char *str, const char **end, uint8_t decimals);
+int32_t strtofix_q(const char *str, const char **end, uint8_t bits);
+int parse_ints(const char *line, char radix, int *out, int max, const char **end);
 void strf_print(strf_putc putc, const char *fmt, va_list args);
-void strf_sprint(char *buf, int size, const char *fmt, va_list args);
+int strf_sprint(char *buf, int size, const char *fmt, va_list args);
+void strf_print_P(strf_putc putc, const char *fmt, va_list args);
+int strf_sprint_P(char *buf, int size, const char *fmt, va_list args);
+void strf_print_bulk(strf_write write, const char *fmt, va_list args);
+void strf_print_bulk_P(strf_write write, const char *fmt, va_list args);
 
 
 void com_init();
@@ -81,16 +169,132 @@ uint8_t com_poll();
 char com_getc();
 char *com_gets(char *buf, uint8_t size, uint8_t echo);
 void com_putc(char c);
+void com_write(const char *data, int n);
 void com_puts(const char *str);
 void com_printf(const char *fmt, ...);
+void com_puts_P(const char *str);
+void com_printf_P(const char *fmt, ...);
 void com_print_buf(const char *title, uint8_t *buf, int n, int wrap);
+typedef void (*hexdump_read)(uint32_t addr, uint8_t *buf, uint8_t n);
+void com_hexdump(uint32_t addr, const uint8_t *data, int n, uint8_t width, uint8_t group, uint8_t flags);
+void com_hexdump_stream(uint32_t addr, uint32_t n, hexdump_read read, uint8_t width, uint8_t group, uint8_t flags);
+void com_set_binary(uint8_t on);
+void com_send_packet(const uint8_t *data, int n);
+int com_recv_packet(uint8_t *buf, int size);
+
+// Binary logging, formatted on the host by tool/log_decode.py (see log.c)
+#define LOG_MARKER  0x1E
+#define LOG(fmt, ...) log_P(PSTR(fmt), ##__VA_ARGS__)
+void log_P(const char *fmt, ...);
 
 
 int b16_encode(const uint8_t *in, int isize, char *out, int osize, int linewidth);
 int b16_decode(const char *in, int isize, uint8_t *out, int osize);
+int b16_decode_inplace(char *buf, int isize);
+int hexdump_line(char *out, uint32_t addr, const uint8_t *data, uint8_t n, uint8_t width, uint8_t group, uint8_t flags);
 int b64_encode_size(int isize, int linewidth);
 int b64_encode(const char *in, int isize, uint8_t *out, int osize, int linewidth);
 int b64_decode(const uint8_t *in, int isize, char *out, int osize);
+int b64_decode_inplace(char *buf, int isize);
+int z85_encode_size(int isize, int linewidth);
+int z85_encode(const uint8_t *in, int isize, char *out, int osize, int linewidth);
+int z85_decode(const char *in, int isize, uint8_t *out, int osize);
+int cobs_encode_size(int isize);
+int cobs_encode(const uint8_t *in, int isize, uint8_t *out, int osize);
+int cobs_decode(const uint8_t *in, int isize, uint8_t *out, int osize);
+
+// Streaming codec states (see coding.c)
+typedef struct { int linewidth, w; } b16_enc;
+typedef struct { uint8_t v, half, done; } b16_dec;
+typedef struct { int linewidth, w; uint8_t p[3], k; } b64_enc;
+typedef struct { uint8_t v[4], k, done; } b64_dec;
+typedef struct { int linewidth, w; uint8_t p[4], k; } z85_enc;
+typedef struct { uint32_t v; uint8_t k, done; } z85_dec;
+typedef struct { uint8_t left, zero, done, error; } cobs_dec;
+void b16_enc_init(b16_enc *s, int linewidth);
+int b16_enc_update(b16_enc *s, const uint8_t *in, int isize, char *out, int osize);
+int b16_enc_final(b16_enc *s, char *out, int osize);
+void b16_dec_init(b16_dec *s);
+int b16_dec_update(b16_dec *s, const char *in, int isize, uint8_t *out, int osize);
+int b16_dec_final(b16_dec *s, uint8_t *out, int osize);
+void b64_enc_init(b64_enc *s, int linewidth);
+int b64_enc_update(b64_enc *s, const uint8_t *in, int isize, char *out, int osize);
+int b64_enc_final(b64_enc *s, char *out, int osize);
+void b64_dec_init(b64_dec *s);
+int b64_dec_update(b64_dec *s, const char *in, int isize, uint8_t *out, int osize);
+int b64_dec_final(b64_dec *s, uint8_t *out, int osize);
+int b64_dec_run(b64_dec *s, const char **in, int *isize, uint8_t *out, int osize);
+void z85_enc_init(z85_enc *s, int linewidth);
+int z85_enc_update(z85_enc *s, const uint8_t *in, int isize, char *out, int osize);
+int z85_enc_final(z85_enc *s, char *out, int osize);
+void z85_dec_init(z85_dec *s);
+int z85_dec_update(z85_dec *s, const char *in, int isize, uint8_t *out, int osize);
+int z85_dec_final(z85_dec *s, uint8_t *out, int osize);
+void cobs_dec_init(cobs_dec *s);
+int cobs_dec_update(cobs_dec *s, const uint8_t *in, int isize, uint8_t *out, int osize);
+#if defined(__x86_64__) && defined(LILLIB_CFG_CODING_X86_SIMD)
+extern uint8_t b64_x86_level;
+int b64_encode_x86(const uint8_t **in, int *isize, uint8_t *out, int osize, int linewidth, int *w);
+int b64_decode_x86(const uint8_t **in, int *isize, uint8_t *out, int osize);
+#endif
+
+// CRC-16/CCITT-FALSE, CRC-16/MODBUS and CRC-32 (see crc.c)
+#define CRC16_CCITT_INIT   0xFFFF
+#define CRC16_MODBUS_INIT  0xFFFF
+#define CRC32_INIT         0
+uint16_t crc16_ccitt_update(uint16_t crc, const void *data, int n);
+uint16_t crc16_modbus_update(uint16_t crc, const void *data, int n);
+uint32_t crc32_update(uint32_t crc, const void *data, int n);
+uint16_t crc16_ccitt_nibble(uint16_t crc, const void *data, int n);
+uint16_t crc16_modbus_nibble(uint16_t crc, const void *data, int n);
+uint32_t crc32_nibble(uint32_t crc, const void *data, int n);
+
+// LZSS compression (see lzss.c), and the output sizes that always suffice for isize bytes in
+#define LZSS_WINDOW        (1<<LILLIB_CFG_LZSS_WINDOW_BITS)
+#define LZSS_MIN_MATCH     2
+#define LZSS_MAX_MATCH     ((1<<LILLIB_CFG_LZSS_LENGTH_BITS)+LZSS_MIN_MATCH-1)
+#define LZSS_MATCH_BITS    (1+LILLIB_CFG_LZSS_WINDOW_BITS+LILLIB_CFG_LZSS_LENGTH_BITS)
+#define LZSS_ENC_SIZE(isize) (((isize)+LZSS_MAX_MATCH)*9/8+2)
+#define LZSS_DEC_SIZE(isize) (((isize)*8/LZSS_MATCH_BITS+1)*LZSS_MAX_MATCH)
+typedef struct { uint8_t ring[LZSS_WINDOW]; uint16_t head, hist; uint8_t fill, bits, nbits; } lzss_enc;
+typedef struct { uint8_t ring[LZSS_WINDOW]; uint16_t pos; uint32_t acc; uint8_t nacc; } lzss_dec;
+void lzss_enc_init(lzss_enc *s);
+int lzss_enc_update(lzss_enc *s, const uint8_t *in, int isize, uint8_t *out, int osize);
+int lzss_enc_final(lzss_enc *s, uint8_t *out, int osize);
+int lzss_encode(const uint8_t *in, int isize, uint8_t *out, int osize);
+void lzss_dec_init(lzss_dec *s);
+int lzss_dec_update(lzss_dec *s, const uint8_t *in, int isize, uint8_t *out, int osize);
+int lzss_decode(const uint8_t *in, int isize, uint8_t *out, int osize);
+
+// Binary telemetry records, decoded on the host by tool/tlm_decode.py (see tlm.c)
+#define TLM_UINT   0
+#define TLM_INT    1
+#define TLM_FIX    2
+#define TLM_BYTES  3
+#define TLM_DELTA  0x04 // Tag flag
+typedef struct
+{
+	uint8_t *buf;
+	int size;
+	int length; // Of everything written, even what didn't fit
+	int32_t prev[LILLIB_CFG_TLM_DELTA_IDS];
+	uint8_t key;
+} tlm_enc;
+typedef struct { const uint8_t *p; int n; int32_t prev[LILLIB_CFG_TLM_DELTA_IDS]; } tlm_dec;
+typedef struct { uint8_t id, type, decimals; int32_t v; const uint8_t *data; int n; } tlm_field;
+void tlm_init(tlm_enc *t);
+void tlm_key(tlm_enc *t);
+void tlm_begin(tlm_enc *t, uint8_t *buf, int size);
+tlm_enc *tlm_uint(tlm_enc *t, uint8_t id, uint32_t v);
+tlm_enc *tlm_int(tlm_enc *t, uint8_t id, int32_t v);
+tlm_enc *tlm_fix(tlm_enc *t, uint8_t id, int32_t v, uint8_t decimals);
+tlm_enc *tlm_int_delta(tlm_enc *t, uint8_t id, int32_t v);
+tlm_enc *tlm_fix_delta(tlm_enc *t, uint8_t id, int32_t v, uint8_t decimals);
+tlm_enc *tlm_bytes(tlm_enc *t, uint8_t id, const void *data, int n);
+int tlm_end(tlm_enc *t);
+void tlm_dec_init(tlm_dec *d);
+void tlm_dec_begin(tlm_dec *d, const uint8_t *buf, int n);
+int tlm_dec_next(tlm_dec *d, tlm_field *f);
 
 
 #ifdef LILLIB_CFG_AES_AVR_ASM
@@ -120,11 +324,33 @@ void aes256_decrypt_ecb(const uint8_t deckey[32], uint8_t cyphertext[16]);
 #endif
 #endif
 
+// AES-128 CTR (with a 32 bit big endian counter in the last 4 bytes), by the AVR asm core where it is built,
+// taking its expanded key, and otherwise by aes128_encrypt_ecb (see aes.c)
+#if defined(__AVR__) && defined(LILLIB_CFG_AES_AVR_ASM)
+#define LILLIB_AES_CTR
+#define AES128_CTR_KEY_SIZE 176
+#elif defined(LILLIB_CFG_AES_128) && defined(LILLIB_CFG_AES_ENCRYPT)
+#define LILLIB_AES_CTR
+#define AES128_CTR_KEY_SIZE 16
+#endif
+#ifdef LILLIB_AES_CTR
+void aes128_ctr_key(const uint8_t key[16], uint8_t ctrkey[AES128_CTR_KEY_SIZE]);
+void aes128_ctr(const uint8_t *ctrkey, uint8_t ctr[16], uint8_t *data, uint8_t n);
+// Base64 straight to CTR decrypted blocks (see coding_aes.c)
+typedef void (*aes_ctr_sink)(const uint8_t *data, uint8_t n);
+typedef struct { const uint8_t *key; aes_ctr_sink sink; b64_dec b64; uint8_t ctr[16], block[18], k; } b64_ctr_dec;
+void b64_ctr_dec_init(b64_ctr_dec *s, const uint8_t *key, const uint8_t ctr[16], aes_ctr_sink sink);
+int b64_ctr_dec_update(b64_ctr_dec *s, const char *in, int isize);
+int b64_ctr_dec_final(b64_ctr_dec *s);
+#endif
+
 
 
 #define LILLIB_CFG_CONSOLE_MAX_ARGV        10
 #define LILLIB_CFG_CONSOLE_LINEBUFSIZE     250
 #define LILLIB_CFG_CONSOLE_STATE_TYPE      void
+// Command usage and desc strings are in flash (PROGMEM/PSTR) rather than RAM
+// #define LILLIB_CFG_CONSOLE_PGM_STRINGS
 //The list of commands is terminated by a command with name==NULL
 typedef struct
 {
@@ -132,7 +358,9 @@ typedef struct
 	int (*func)(uint8_t argc, char *argv[], LILLIB_CFG_CONSOLE_STATE_TYPE *state);
 	const char *usage;
 	const char *desc;
+	uint8_t flags;
 } _console_cmd;
+#define CONSOLE_CMD_RAW  0x01  // Args aren't split: argv[1] is the rest of the line (e.g. for parse_ints)
 
 int console(const _console_cmd *commands, LILLIB_CFG_CONSOLE_STATE_TYPE *state);
 
@@ -170,5 +398,56 @@ extern const FontData fontVB_piXelize;
 
 #ifdef __cplusplus
 } // extern "C"
+
+// Flash strings for C++: FSTR("...") is typed so the overloads below pick the _P functions, e.g.
+//   com_printf(FSTR("x=%i\n"), x);
+extern "C++" { // In case this header was included inside extern "C"
+struct FlashStr;
+#define FSTR(s) (reinterpret_cast<const FlashStr *>(PSTR(s)))
+static inline void com_puts(const FlashStr *str) { com_puts_P(reinterpret_cast<const char *>(str)); }
+static inline void com_printf(const FlashStr *fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	strf_print_P(com_putc, reinterpret_cast<const char *>(fmt), args);
+	va_end(args);
+}
+static inline int qsprintf(char *buf, int size, const FlashStr *fmt, ...)
+{
+	int n;
+	va_list args;
+	va_start(args, fmt);
+	n = strf_sprint_P(buf, size, reinterpret_cast<const char *>(fmt), args);
+	va_end(args);
+	return n;
+}
+
+// strb with chaining, and StrBuf<N> which holds its own buffer, e.g.
+//   StrBuf<32> s;
+//   s.append_str("t=").append_fix(t, 2).append_char('\n');
+//   com_puts(s.c_str());
+struct StrBuilder : strb
+{
+	StrBuilder(char *buf, int size) { strb_init(this, buf, size); }
+	StrBuilder &append_str(const char *s)     { strb_append_str(this, s); return *this; }
+	StrBuilder &append_str(const FlashStr *s) { strb_append_str_P(this, reinterpret_cast<const char *>(s)); return *this; }
+	StrBuilder &append_char(char c)           { strb_append_char(this, c); return *this; }
+	StrBuilder &append_int(int32_t v, char radix=10, int8_t width=0, char fill=' ') { strb_append_int(this, v, radix, width, fill); return *this; }
+	StrBuilder &append_hex(uint32_t v, uint8_t digits=0) { strb_append_hex(this, v, digits); return *this; }
+	StrBuilder &append_fix(int32_t v, uint8_t decimals)  { strb_append_fix(this, v, decimals); return *this; }
+	StrBuilder &clear()                       { strb_init(this, buf, size); return *this; }
+	const char *c_str() const { return buf; }
+	int len() const           { return length; }
+	bool truncated() const    { return strb_truncated(this); }
+};
+
+template <int N>
+struct StrBuf : StrBuilder
+{
+	char data[N];
+	StrBuf() : StrBuilder(data, N) {}
+	StrBuf(const StrBuf &) = delete; // buf would point into the other one
+};
+} // extern "C++"
 #endif
 #endif // _LILLIB_H_
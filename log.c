@@ -0,0 +1,107 @@
+#include "lillib.h"
+
+// Binary deferred logging.  LOG(fmt, ...) doesn't format anything, it sends the flash address of fmt and
+// the raw bytes of the arguments, and tool/log_decode.py does the formatting on the host using the ELF.
+// A record on the wire is:
+//   LOG_MARKER, n, then n bytes carrying the payload 7 bits per byte, LSB first (the UART only sends 7)
+// The payload is the address of fmt and then each argument as it's stored in memory (all our targets are
+// little endian): ints, longs, doubles and %S (flash string) pointers at their size, hh/h/c at 1/2/1 bytes
+// and %s as its chars and a NUL.  Arguments that don't fit in LILLIB_CFG_LOG_RECORD_SIZE are dropped (the
+// decoder shows them as "<?>").
+// fmt is scanned here for the argument types, so specs must be parsed exactly as strf_conv does.
+
+#define LOG_FMT(i) ((char)pgm_read_byte(fmt+(i)))
+
+typedef struct
+{
+	uint8_t buf[LILLIB_CFG_LOG_RECORD_SIZE];
+	uint8_t n;
+} log_record;
+
+// Adds n bytes of an argument, if there's room for all of them
+static uint8_t log_add(log_record *r, const void *data, uint8_t n)
+{
+	if (r->n+n>LILLIB_CFG_LOG_RECORD_SIZE) return 0;
+	qmemcpy(r->buf+r->n, data, n), r->n += n;
+	return 1;
+}
+
+static uint8_t log_add_int(log_record *r, va_list *args, uint8_t n)
+{
+	unsigned int v = va_arg(*args, unsigned int);
+	return log_add(r, &v, n);
+}
+
+static uint8_t log_add_str(log_record *r, const char *s)
+{
+	// Strings are cut short to fit, but always get their NUL
+	if (r->n>=LILLIB_CFG_LOG_RECORD_SIZE) return 0;
+	while (*s && r->n<LILLIB_CFG_LOG_RECORD_SIZE-1) r->buf[r->n++] = *s++;
+	r->buf[r->n++] = 0;
+	return 1;
+}
+
+void log_P(const char *fmt, ...)
+{
+	log_record r;
+	uint8_t wire[2+(8*LILLIB_CFG_LOG_RECORD_SIZE+6)/7];
+	uint8_t i, n, bits, ok = 1;
+	uint16_t acc;
+	char c, size;
+	va_list args;
+	va_start(args, fmt);
+	r.n = 0;
+	log_add(&r, &fmt, sizeof(fmt));
+	while (ok && (c=LOG_FMT(0)))
+	{
+		fmt++;
+		if (c!='%') continue;
+		// Skip the spec up to any '*' args and the length modifier, as strf_conv parses it
+		c = LOG_FMT(1);
+		if (LOG_FMT(0) && (c=='-' || c=='<' || c=='>' || c=='=' || c=='^')) fmt += 2;
+		else if ((c=LOG_FMT(0))=='-' || c=='<' || c=='>' || c=='=' || c=='^') fmt++;
+		if ((c=LOG_FMT(0))=='+' || c==' ') fmt++;
+		if (LOG_FMT(0)=='0') fmt++;
+		if (LOG_FMT(0)=='*') ok &= log_add_int(&r, VA_LIST_PTR(args), sizeof(int)), fmt++;
+		else while ((c=LOG_FMT(0))>='0' && c<='9') fmt++;
+		if (LOG_FMT(0)=='.')
+		{
+			fmt++;
+			if (LOG_FMT(0)=='*') ok &= log_add_int(&r, VA_LIST_PTR(args), sizeof(int)), fmt++;
+			else while ((c=LOG_FMT(0))>='0' && c<='9') fmt++;
+		}
+		size = 0;
+		if ((c=LOG_FMT(0))=='h' || c=='l') size = (LOG_FMT(1)==c ? c&~0x20 : c), fmt += (LOG_FMT(1)==c ? 2 : 1);
+		switch ((c=LOG_FMT(0)))
+		{
+			case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'b': case 'p': case '$':
+				if      (size=='H') ok &= log_add_int(&r, VA_LIST_PTR(args), 1);
+				else if (size=='h') ok &= log_add_int(&r, VA_LIST_PTR(args), 2);
+				else if (size=='l') { unsigned long v = va_arg(args, unsigned long); ok &= log_add(&r, &v, sizeof(v)); }
+				else if (size=='L') { unsigned long long v = va_arg(args, unsigned long long); ok &= log_add(&r, &v, sizeof(v)); }
+				else                ok &= log_add_int(&r, VA_LIST_PTR(args), sizeof(int));
+				break;
+			case 'k': case 'K':
+				{ uint32_t v = va_arg(args, uint32_t); ok &= log_add(&r, &v, sizeof(v)); }
+				break;
+			case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+				{ double v = va_arg(args, double); ok &= log_add(&r, &v, sizeof(v)); }
+				break;
+			case 's': ok &= log_add_str(&r, va_arg(args, const char *)); break;
+			case 'S': { const char *v = va_arg(args, const char *); ok &= log_add(&r, &v, sizeof(v)); } break;
+			case 'c': ok &= log_add_int(&r, VA_LIST_PTR(args), 1); break;
+		}
+		if (c) fmt++;
+	}
+	va_end(args);
+	// Pack into 7 bit bytes
+	wire[0] = LOG_MARKER;
+	for (i=0, n=2, acc=0, bits=0; i<r.n; i++)
+	{
+		acc |= (uint16_t)r.buf[i]<<bits, bits += 8;
+		while (bits>=7) wire[n++] = acc&0x7F, acc >>= 7, bits -= 7;
+	}
+	if (bits) wire[n++] = acc&0x7F;
+	wire[1] = n-2;
+	com_write((const char *)wire, n);
+}
@@ -0,0 +1,144 @@
+#include "lillib.h"
+
+// LZSS compression, heatshrink style: a bit stream (MSB first) of tokens, each either a 1 and an 8 bit
+// literal, or a 0, WINDOW_BITS of the match distance-1 and LENGTH_BITS of its length-LZSS_MIN_MATCH, the
+// match being a copy of earlier output (which may overlap what it makes, for runs).  The last byte is padded
+// with zeros, which can't make a whole token.
+//
+// Both ends keep the last LZSS_WINDOW bytes in a ring, and that's all the RAM they need.  The compressor's
+// ring also holds its lookahead, so matches reach LZSS_WINDOW-LZSS_MAX_MATCH back.  It searches the window
+// for the longest match at every token (nearest first), which is simple and costs no more RAM, but makes it
+// slow on data that won't compress, so keep the window small on small chips.
+#define LZSS_MASK (LZSS_WINDOW-1)
+
+static int lzss_put_bits(lzss_enc *s, uint16_t v, uint8_t k, uint8_t *out, int n, int osize)
+{
+	while (k--)
+	{
+		s->bits = s->bits<<1 | (v>>k & 1);
+		if (++s->nbits==8)
+		{
+			if (n<osize) out[n++] = s->bits;
+			s->nbits = 0;
+		}
+	}
+	return n;
+}
+
+void lzss_enc_init(lzss_enc *s)
+{
+	s->head = 0, s->fill = 0, s->hist = 0, s->bits = 0, s->nbits = 0;
+}
+
+// Encodes the token at the head of the lookahead
+static int lzss_token(lzss_enc *s, uint8_t *out, int n, int osize)
+{
+	const uint8_t *r = s->ring;
+	uint16_t h = s->head, d, best_d = 0;
+	uint8_t c = r[h&LZSS_MASK], l, best = 1, max = (s->fill<LZSS_MAX_MATCH ? s->fill : LZSS_MAX_MATCH);
+	for (d=1; d<=s->hist; d++)
+	{
+		if (r[(h-d)&LZSS_MASK]!=c) continue;
+		for (l=1; l<max && r[(h-d+l)&LZSS_MASK]==r[(h+l)&LZSS_MASK]; l++);
+		if (l>best)
+		{
+			best = l, best_d = d;
+			if (l==max) break;
+		}
+	}
+	if (best>=LZSS_MIN_MATCH)
+	{
+		n = lzss_put_bits(s, 0, 1, out, n, osize);
+		n = lzss_put_bits(s, best_d-1, LILLIB_CFG_LZSS_WINDOW_BITS, out, n, osize);
+		n = lzss_put_bits(s, best-LZSS_MIN_MATCH, LILLIB_CFG_LZSS_LENGTH_BITS, out, n, osize);
+	}
+	else
+	{
+		best = 1;
+		n = lzss_put_bits(s, 0x100|c, 9, out, n, osize);
+	}
+	s->head += best, s->fill -= best, s->hist += best;
+	if (s->hist>LZSS_WINDOW-LZSS_MAX_MATCH) s->hist = LZSS_WINDOW-LZSS_MAX_MATCH;
+	return n;
+}
+
+// Compresses in, keeping the last LZSS_MAX_MATCH-1 bytes or so as lookahead for the next update or final.
+// out needs room for LZSS_ENC_SIZE(isize), and anything past osize is lost.  Returns the number of bytes.
+int lzss_enc_update(lzss_enc *s, const uint8_t *in, int isize, uint8_t *out, int osize)
+{
+	int n=0;
+	while (isize-->0)
+	{
+		s->ring[(s->head+s->fill++)&LZSS_MASK] = *in++;
+		if (s->fill==LZSS_MAX_MATCH) n = lzss_token(s, out, n, osize);
+	}
+	return n;
+}
+
+// The rest of the lookahead, and the padding
+int lzss_enc_final(lzss_enc *s, uint8_t *out, int osize)
+{
+	int n=0;
+	while (s->fill) n = lzss_token(s, out, n, osize);
+	if (s->nbits) n = lzss_put_bits(s, 0, 8-s->nbits, out, n, osize);
+	return n;
+}
+
+int lzss_encode(const uint8_t *in, int isize, uint8_t *out, int osize)
+{
+	lzss_enc s;
+	int n;
+	lzss_enc_init(&s);
+	n = lzss_enc_update(&s, in, isize, out, osize);
+	return n + lzss_enc_final(&s, out+n, osize-n);
+}
+
+void lzss_dec_init(lzss_dec *s)
+{
+	s->pos = 0, s->acc = 0, s->nacc = 0;
+}
+
+// Decompresses in, keeping any partial token for the next update.  Returns the number of bytes, which stops
+// at osize (so give it LZSS_DEC_SIZE(isize) to be sure of getting it all).
+int lzss_dec_update(lzss_dec *s, const uint8_t *in, int isize, uint8_t *out, int osize)
+{
+	int n=0;
+	uint16_t d, pos=s->pos;
+	uint8_t l, c;
+	while (isize-->0)
+	{
+		s->acc = s->acc<<8 | *in++, s->nacc += 8;
+		while (1)
+		{
+			if (s->nacc>=9 && s->acc>>(s->nacc-1) & 1)
+			{
+				s->nacc -= 9;
+				c = s->acc>>s->nacc;
+				s->ring[pos++&LZSS_MASK] = c;
+				if (n<osize) out[n++] = c;
+			}
+			else if (s->nacc>=LZSS_MATCH_BITS && !(s->acc>>(s->nacc-1) & 1))
+			{
+				s->nacc -= LZSS_MATCH_BITS;
+				d = (s->acc>>(s->nacc+LILLIB_CFG_LZSS_LENGTH_BITS) & LZSS_MASK) + 1;
+				l = (s->acc>>s->nacc & ((1<<LILLIB_CFG_LZSS_LENGTH_BITS)-1)) + LZSS_MIN_MATCH;
+				for ( ; l; l--, pos++)
+				{
+					c = s->ring[pos&LZSS_MASK] = s->ring[(pos-d)&LZSS_MASK];
+					if (n<osize) out[n++] = c;
+				}
+			}
+			else break;
+		}
+		s->acc &= ((uint32_t)1<<s->nacc)-1;
+	}
+	s->pos = pos;
+	return n;
+}
+
+int lzss_decode(const uint8_t *in, int isize, uint8_t *out, int osize)
+{
+	lzss_dec s;
+	lzss_dec_init(&s);
+	return lzss_dec_update(&s, in, isize, out, osize);
+}
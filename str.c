@@ -1,8 +1,40 @@
 #include "lillib.h"
 
+// Memory and string primitives.  On the AVR, qmemcpy/qmemset are asm loops around ld X+/st Z+ unrolled 4
+// times, and the searches are plain loops (they exit early, so unrolling gains little and gcc already
+// makes ld X+ loops of them).  Elsewhere they go a word at a time, with the usual SWAR tests for a zero
+// byte in a word.
+#ifndef __AVR__
+typedef unsigned long str_word;
+typedef unsigned long __attribute__((may_alias)) str_word_a; // For aligned loads of char data
+#define STR_WORD            sizeof(str_word)
+#define STR_ONES            ((str_word)-1/0xFF)      // 0x0101...
+#define STR_HIGHS           (STR_ONES*0x80)          // 0x8080...
+#define STR_HASZERO(x)      (((x)-STR_ONES) & ~(x) & STR_HIGHS)
+
+// Scanning for a NUL reads whole aligned words, so may read past it (but never into the next page).  That
+// is fine except under ASan, which rightly complains.
+#if defined(__SANITIZE_ADDRESS__)
+#define STR_NO_SWAR_SCAN
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define STR_NO_SWAR_SCAN
+#endif
+#endif
+#ifndef STR_NO_SWAR_SCAN
+#define STR_SWAR_SCAN
+#endif
+#endif
+
 int qstrlen(const char *str)
 {
 	const char *start = str;
+#ifdef STR_SWAR_SCAN
+	const str_word_a *w;
+	for ( ; (unsigned long)str%STR_WORD; str++) if (!*str) return str - start;
+	for (w=(const str_word_a *)str; !STR_HASZERO(*w); w++);
+	str = (const char *)w;
+#endif
 	while (*str) str++;
 	return str - start;
 }
@@ -16,3 +48,221 @@ char qstrcmp(const char *a, const char *b)
 		if (ca==0) return 0;
 	}
 }
+
+int qstrlen_P(const char *str)
+{
+	const char *start = str;
+	while (pgm_read_byte(str)) str++;
+	return str - start;
+}
+
+// First c in str, or its end if there is none
+char *qstrchrnul(const char *str, char c)
+{
+#ifdef STR_SWAR_SCAN
+	const str_word_a *w;
+	str_word x, p = STR_ONES*(uint8_t)c;
+	for ( ; (unsigned long)str%STR_WORD; str++) if (*str==c || !*str) return (char *)str;
+	for (w=(const str_word_a *)str; x=*w, !STR_HASZERO(x) && !STR_HASZERO(x^p); w++);
+	str = (const char *)w;
+#endif
+	while (*str!=c && *str) str++;
+	return (char *)str;
+}
+
+// First c in str, or NULL (c may be 0, to find the end)
+char *qstrchr(const char *str, char c)
+{
+	str = qstrchrnul(str, c);
+	return (*str==c ? (char *)str : NULL);
+}
+
+void *qmemchr(const void *mem, char c, int n)
+{
+	const char *p = (const char *)mem;
+#ifndef __AVR__
+	str_word x, m, pat = STR_ONES*(uint8_t)c;
+	for ( ; n>=(int)STR_WORD; n-=STR_WORD, p+=STR_WORD)
+	{
+		__builtin_memcpy(&x, p, STR_WORD);
+		// It's in this word.  The lowest flag is always a real match (only bytes above one can be flagged
+		// falsely), so on little endian hosts it gives the position.
+		if ((m=STR_HASZERO(x^pat)))
+		{
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+			return (void *)(p + (__builtin_ctzl(m)>>3));
+#else
+			break;
+#endif
+		}
+	}
+#endif
+	for ( ; n>0; n--, p++) if (*p==c) return (void *)p;
+	return NULL;
+}
+
+// As memcmp: <0, 0 or >0 as the first differing byte (unsigned) of a is less, equal or greater
+int qmemcmp(const void *a, const void *b, int n)
+{
+	const uint8_t *pa = (const uint8_t *)a, *pb = (const uint8_t *)b;
+#ifndef __AVR__
+	str_word x, y;
+	for ( ; n>=(int)STR_WORD; n-=STR_WORD, pa+=STR_WORD, pb+=STR_WORD)
+	{
+		__builtin_memcpy(&x, pa, STR_WORD);
+		__builtin_memcpy(&y, pb, STR_WORD);
+		if (x!=y) break; // The difference is in this word
+	}
+#endif
+	for ( ; n>0; n--, pa++, pb++) if (*pa!=*pb) return *pa - *pb;
+	return 0;
+}
+
+#ifdef __AVR__
+// n%4 bytes, then 4 per loop, with one "op" storing the next byte to Z+ (and maybe loading it from X+)
+#define STR_AVR_LOOP4(op)               \
+		"   rjmp  2f              \n"   \
+		"1: " op                        \
+		"2: subi  %[r], 1         \n"   \
+		"   brcc  1b              \n"   \
+		"   rjmp  4f              \n"   \
+		"3: " op op op op               \
+		"4: subi  %A[q], 1        \n"   \
+		"   sbci  %B[q], 0        \n"   \
+		"   brcc  3b              \n"
+
+void *qmemcpy(void *dst, const void *src, int n)
+{
+	uint8_t *d = (uint8_t *)dst;
+	const uint8_t *s = (const uint8_t *)src;
+	uint16_t q;
+	uint8_t r, t;
+	if (n<=0) return dst;
+	q = (uint16_t)n>>2, r = n&3;
+	__asm__ volatile (
+		STR_AVR_LOOP4("ld %[t], X+ \n st Z+, %[t] \n")
+		: [s] "+x" (s), [d] "+z" (d), [q] "+d" (q), [r] "+d" (r), [t] "=&r" (t)
+		:
+		: "memory"
+	);
+	return dst;
+}
+
+void *qmemset(void *dst, char c, int n)
+{
+	uint8_t *d = (uint8_t *)dst;
+	uint16_t q;
+	uint8_t r;
+	if (n<=0) return dst;
+	q = (uint16_t)n>>2, r = n&3;
+	__asm__ volatile (
+		STR_AVR_LOOP4("st Z+, %[c] \n")
+		: [d] "+z" (d), [q] "+d" (q), [r] "+d" (r)
+		: [c] "r" (c)
+		: "memory"
+	);
+	return dst;
+}
+#else
+void *qmemcpy(void *dst, const void *src, int n)
+{
+	char *d = (char *)dst;
+	const char *s = (const char *)src;
+	str_word x;
+	for ( ; n>=(int)STR_WORD; n-=STR_WORD, d+=STR_WORD, s+=STR_WORD)
+	{
+		__builtin_memcpy(&x, s, STR_WORD);
+		__builtin_memcpy(d, &x, STR_WORD);
+	}
+	for ( ; n>0; n--) *d++ = *s++;
+	return dst;
+}
+
+void *qmemset(void *dst, char c, int n)
+{
+	char *d = (char *)dst;
+	str_word x = STR_ONES*(uint8_t)c;
+	for ( ; n>=(int)STR_WORD; n-=STR_WORD, d+=STR_WORD) __builtin_memcpy(d, &x, STR_WORD);
+	for ( ; n>0; n--) *d++ = c;
+	return dst;
+}
+#endif
+
+// Fixed capacity string builder.  Appends never write past size (and keep buf NUL terminated), while length
+// keeps counting, so it ends up as the length the whole string needed (as strf_sprint returns) and
+// strb_truncated() says whether it didn't fit.  Each append returns b, for chaining.
+void strb_init(strb *b, char *buf, int size)
+{
+	b->buf = buf, b->size = size, b->length = 0;
+	if (size>0) buf[0] = 0;
+}
+
+// n chars from s, or if s==NULL, n copies of c (as strf_write)
+strb *strb_append(strb *b, const char *s, int n, char c)
+{
+	int k = b->size-1-b->length;
+	if (k>n) k = n;
+	if (k>0)
+	{
+		if (s) qmemcpy(b->buf+b->length, s, k);
+		else   qmemset(b->buf+b->length, c, k);
+		b->buf[b->length+k] = 0;
+	}
+	b->length += n;
+	return b;
+}
+
+strb *strb_append_str(strb *b, const char *s)
+{
+	return strb_append(b, s, qstrlen(s), 0);
+}
+
+strb *strb_append_str_P(strb *b, const char *s)
+{
+	char c;
+	while ((c=pgm_read_byte(s++))) strb_append(b, &c, 1, 0);
+	return b;
+}
+
+strb *strb_append_char(strb *b, char c)
+{
+	return strb_append(b, &c, 1, 0);
+}
+
+// v in radix, signed in radix 10 and otherwise taken as unsigned (as %x), upper case.  Padded with fill to
+// width, on the left, or on the right if width<0.  Zeros go after a '-'.
+strb *strb_append_int(strb *b, int32_t v, char radix, int8_t width, char fill)
+{
+	char tmp[34]; // 32 bits in base 2, sign and NUL
+	char *s = itoa2_32(tmp+sizeof(tmp), v, radix, (radix==10 ? ITOA2_SIGNED : 0) | ITOA2_UCASE);
+	int n = tmp+sizeof(tmp)-1-s;
+	int pad = (width<0 ? -width : width) - n;
+	if (pad>0 && width>0)
+	{
+		if (fill=='0' && *s=='-') strb_append(b, s++, 1, 0), n--;
+		strb_append(b, NULL, pad, fill);
+	}
+	strb_append(b, s, n, 0);
+	if (pad>0 && width<0) strb_append(b, NULL, pad, fill);
+	return b;
+}
+
+// v in hex, zero padded to digits
+strb *strb_append_hex(strb *b, uint32_t v, uint8_t digits)
+{
+	return strb_append_int(b, (int32_t)v, 16, digits, '0');
+}
+
+// v/10^decimals, formatted exactly as %.<decimals>$ does
+strb *strb_append_fix(strb *b, int32_t v, uint8_t decimals)
+{
+	char tmp[48];
+	char *e = tmp+sizeof(tmp)-1;
+	char *s = itoa2_32(tmp+sizeof(tmp), v, 10, ITOA2_SIGNED|ITOA2_NOSIGN);
+	if (decimals>32) decimals = 32;
+	while (e-s<decimals) *--s = '0';
+	if (v<0) strb_append(b, "-", 1, 0);
+	strb_append(b, s, e-s-decimals, 0);
+	strb_append(b, ".", 1, 0);
+	return strb_append(b, e-decimals, decimals, 0);
+}
@@ -68,3 +68,87 @@ TEST(aes, x256)
 //aes_test_ecb("8E73B0F7DA0E6452C810F32B809079E562F8EAD2522C6B7B", "AE2D8A571E03AC9C9EB76FAC45AF8E51", "974104846D0AD3AD7734ECB3ECEE4EEF");
 //aes_test_ecb("8E73B0F7DA0E6452C810F32B809079E562F8EAD2522C6B7B", "30C81C46A35CE411E5FBC1191A0A52EF", "EF7AFD2270E2E60ADCE0BA2FACE6444E");
 //aes_test_ecb("8E73B0F7DA0E6452C810F32B809079E562F8EAD2522C6B7B", "F69F2445DF4F9B17AD2B417BE66C3710", "9A4B41BA738D6C72FB16691603C18E0E");
+
+// SP 800-38A F.5.1/F.5.2, CTR-AES128
+static const char *g_ctr_key = "2B7E151628AED2A6ABF7158809CF4F3C";
+static const char *g_ctr_iv  = "F0F1F2F3F4F5F6F7F8F9FAFBFCFDFEFF";
+static const char *g_ctr_pt  = "6BC1BEE22E409F96E93D7E117393172AAE2D8A571E03AC9C9EB76FAC45AF8E51"
+                               "30C81C46A35CE411E5FBC1191A0A52EFF69F2445DF4F9B17AD2B417BE66C3710";
+static const char *g_ctr_ct  = "874D6191B620E3261BEF6864990DB6CE9806F66B7970FDFF8617187BB9FFFDFF"
+                               "5AE4DF3EDBD5D35E5B4F09020DB03EAB1E031DDA2FBE03D1792170A0F3009CEE";
+
+TEST(aes, ctr)
+{
+	uint8_t key[16], ctrkey[AES128_CTR_KEY_SIZE], ctr[16], data[64], ct[64];
+	b16_decode(g_ctr_key, -1, key, 16);
+	b16_decode(g_ctr_iv, -1, ctr, 16);
+	b16_decode(g_ctr_pt, -1, data, 64);
+	b16_decode(g_ctr_ct, -1, ct, 64);
+	aes128_ctr_key(key, ctrkey);
+	aes128_ctr(ctrkey, ctr, data, 4);
+	EXPECT_EQ(memcmp(data, ct, 64), 0);
+	// The counter carries through its last 4 bytes only
+	EXPECT_EQ(ctr[15], 0x03);
+	EXPECT_EQ(ctr[14], 0xFF);
+	EXPECT_EQ(ctr[11], 0xFB);
+	memset(ctr+12, 0xFF, 4);
+	aes128_ctr(ctrkey, ctr, data, 1);
+	EXPECT_EQ(ctr[11], 0xFB);
+	EXPECT_EQ(ctr[12]|ctr[13]|ctr[14]|ctr[15], 0);
+}
+
+static std::vector<uint8_t> g_b64_ctr_out;
+static void b64_ctr_sink(const uint8_t *data, uint8_t n)
+{
+	EXPECT_LE(n, 16);
+	g_b64_ctr_out.insert(g_b64_ctr_out.end(), data, data+n);
+}
+
+TEST(aes, b64_ctr)
+{
+	// The fused stage gives what decoding and then decrypting do, fed in pieces of any size
+	uint8_t key[16], ctrkey[AES128_CTR_KEY_SIZE], iv[16], ctr[16], pt[304], ct[304], tmp[304]; // Whole blocks for aes128_ctr
+	char text[500];
+	b16_decode(g_ctr_key, -1, key, 16);
+	b16_decode(g_ctr_iv, -1, iv, 16);
+	aes128_ctr_key(key, ctrkey);
+	srand(49);
+	for (auto &v : pt) v = rand();
+	for (int len : { 0, 1, 2, 15, 16, 17, 18, 31, 47, 48, 64, 100, 299 })
+	{
+		for (int linewidth : { 0, 7, 76 })
+		{
+			// The reference: encrypt, encode, then decode and decrypt separately
+			memcpy(ct, pt, len);
+			memcpy(ctr, iv, 16);
+			aes128_ctr(ctrkey, ctr, ct, (len+15)/16);
+			int k = b64_encode((const char *)ct, len, (uint8_t *)text, sizeof(text), linewidth);
+			ASSERT_EQ(b64_decode((const uint8_t *)text, k, (char *)tmp, sizeof(tmp)), len);
+			memcpy(ctr, iv, 16);
+			aes128_ctr(ctrkey, ctr, tmp, (len+15)/16);
+			ASSERT_EQ(memcmp(tmp, pt, len), 0);
+			for (int piece : { 1, 3, 5, 16, 1000 })
+			{
+				b64_ctr_dec s;
+				int n = 0;
+				g_b64_ctr_out.clear();
+				b64_ctr_dec_init(&s, ctrkey, iv, b64_ctr_sink);
+				for (int i=0; i<k; i+=piece) n += b64_ctr_dec_update(&s, text+i, std::min(piece, k-i));
+				n += b64_ctr_dec_final(&s);
+				EXPECT_EQ(n, len);
+				ASSERT_EQ(g_b64_ctr_out, std::vector<uint8_t>(pt, pt+len)) << len << " " << linewidth << " " << piece;
+			}
+		}
+	}
+	// NUL terminated, and stopping at padding
+	b64_ctr_dec s;
+	memcpy(ct, pt, 20);
+	memcpy(ctr, iv, 16);
+	aes128_ctr(ctrkey, ctr, ct, 2);
+	b64_encode((const char *)ct, 20, (uint8_t *)text, sizeof(text), 0);
+	strcat(text, "QUJD");
+	g_b64_ctr_out.clear();
+	b64_ctr_dec_init(&s, ctrkey, iv, b64_ctr_sink);
+	EXPECT_EQ(b64_ctr_dec_update(&s, text, -1) + b64_ctr_dec_final(&s), 20);
+	EXPECT_EQ(g_b64_ctr_out, std::vector<uint8_t>(pt, pt+20));
+}
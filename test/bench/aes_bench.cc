@@ -0,0 +1,47 @@
+#include "bench.h"
+
+#ifdef LILLIB_AES_CTR
+// The consumer: a CRC of the plaintext, as a firmware chunk would get
+static uint32_t g_aes_crc;
+static void aes_bench_sink(const uint8_t *data, uint8_t n)
+{
+	g_aes_crc = crc32_update(g_aes_crc, data, n);
+}
+
+// A base64 CTR payload to plaintext: decoded, decrypted and consumed a stage at a time through a buffer
+// (255 blocks at most per aes128_ctr), against the fused b64_ctr_dec
+BENCH(aes_ctr)
+{
+	static uint8_t data[4096], buf[4096];
+	static char text[6000];
+	uint8_t key[16], ctrkey[AES128_CTR_KEY_SIZE], iv[16], ctr[16];
+	for (int i=0; i<16; i++) key[i] = i*7, iv[i] = i*11;
+	for (int i=0; i<(int)sizeof(data); i++) data[i] = (uint8_t)(i*167+13);
+	aes128_ctr_key(key, ctrkey);
+	for (int n : { 64, 256, 4096 })
+	{
+		char name[48];
+		int k = b64_encode((const char *)data, n, (uint8_t *)text, sizeof(text), 76);
+		snprintf(name, sizeof(name), "aes128_ctr          %5i", n);
+		bench_report(name, bench_ns([&]() {
+			memcpy(ctr, iv, 16);
+			for (int i=0; i<n; i+=256) aes128_ctr(ctrkey, ctr, data+i, (n-i<256 ? n-i : 256)/16);
+			g_bench_sink += ctr[15];
+		}), n);
+		snprintf(name, sizeof(name), "b64 + ctr, staged   %5i", n);
+		bench_report(name, bench_ns([&]() {
+			int m = b64_decode((const uint8_t *)text, k, (char *)buf, sizeof(buf));
+			memcpy(ctr, iv, 16);
+			for (int i=0; i<m; i+=256) aes128_ctr(ctrkey, ctr, buf+i, (m-i<256 ? m-i+15 : 256)/16);
+			g_bench_sink += crc32_update(CRC32_INIT, buf, m);
+		}), n);
+		snprintf(name, sizeof(name), "b64 + ctr, fused    %5i", n);
+		bench_report(name, bench_ns([&]() {
+			b64_ctr_dec s;
+			g_aes_crc = CRC32_INIT;
+			b64_ctr_dec_init(&s, ctrkey, iv, aes_bench_sink);
+			g_bench_sink += b64_ctr_dec_update(&s, text, k) + b64_ctr_dec_final(&s) + g_aes_crc;
+		}), n);
+	}
+}
+#endif
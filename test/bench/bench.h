@@ -0,0 +1,52 @@
+#pragma once
+
+// Tiny throughput benchmark framework.  Each BENCH(name) body times some operations with bench_ns(), which
+// runs its function enough times to time it and returns the ns per call, and prints
+// them with bench_report().  bench.elf [filter...] runs the benchmarks whose names contain a filter.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+extern "C"
+{
+#include "lillib.h"
+}
+
+typedef void (*bench_fn)(void);
+
+struct Bench
+{
+	Bench(const char *name, bench_fn fn);
+};
+
+#define BENCH(name) \
+	static void bench_##name(); \
+	static Bench bench_reg_##name(#name, bench_##name); \
+	static void bench_##name()
+
+// Sink for results, so the compiler can't throw away the work being timed
+extern volatile uintptr_t g_bench_sink;
+
+template <typename F>
+double bench_ns(F f)
+{
+	// Calibrate to ~10ms, then take the best of 5 runs, which is the least disturbed by anything else
+	typedef std::chrono::steady_clock clock;
+	long n = 1;
+	double best = 0;
+	for (int run=0; run<5; )
+	{
+		auto t0 = clock::now();
+		for (long i=0; i<n; i++) f();
+		double ns = std::chrono::duration<double, std::nano>(clock::now()-t0).count();
+		if (ns<10e6) { n = (ns<1e5 ? n*10 : (long)(n*12e6/ns)); continue; }
+		if (!run++ || ns/n<best) best = ns/n;
+	}
+	return best;
+}
+
+// One line of results: ns per call, and MB/s if each call processes bytes bytes
+void bench_report(const char *what, double ns, size_t bytes = 0);
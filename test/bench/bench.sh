@@ -0,0 +1,12 @@
+#!/bin/bash
+# Builds and runs the throughput benchmarks (optimized, unlike the tests).
+#   bench.sh [filter...]   Run the benchmarks whose names contain a filter (default all)
+
+cd "$(dirname "$(readlink -f "$0")")"
+mkdir -p __builddir__
+FLAGS="-O2 -Wall -D TESTING -I ../../ -I .. -I ."
+
+for f in ../../*.c; do gcc $FLAGS -c "$f" -o "__builddir__/$(basename "$f").o" || exit; done
+g++ $FLAGS *.cc __builddir__/*.c.o -lm -o __builddir__/bench.elf || exit
+
+__builddir__/bench.elf "$@"
@@ -0,0 +1,99 @@
+#include "bench.h"
+
+// Encoding and decoding throughput, in MB/s of binary data
+BENCH(coding)
+{
+	static uint8_t data[1024], back[1024];
+	static char text[2048];
+	for (int i=0; i<(int)sizeof(data); i++) data[i] = (uint8_t)(i*167+13);
+	int n64 = b64_encode((const char *)data, sizeof(data), (uint8_t *)text, sizeof(text), 0);
+	bench_report("b64_encode", bench_ns([&]() {
+		g_bench_sink += b64_encode((const char *)data, sizeof(data), (uint8_t *)text, sizeof(text), 0);
+	}), sizeof(data));
+	bench_report("b64_encode wrapped", bench_ns([&]() {
+		g_bench_sink += b64_encode((const char *)data, sizeof(data), (uint8_t *)text, sizeof(text), 76);
+	}), sizeof(data));
+	b64_encode((const char *)data, sizeof(data), (uint8_t *)text, sizeof(text), 0);
+	bench_report("b64_decode", bench_ns([&]() {
+		g_bench_sink += b64_decode((const uint8_t *)text, n64, (char *)back, sizeof(back));
+	}), sizeof(data));
+	b64_encode((const char *)data, sizeof(data), (uint8_t *)text, sizeof(text), 76);
+	bench_report("b64_decode wrapped", bench_ns([&]() {
+		g_bench_sink += b64_decode((const uint8_t *)text, -1, (char *)back, sizeof(back));
+	}), sizeof(data));
+	bench_report("b16_encode", bench_ns([&]() {
+		g_bench_sink += b16_encode(data, sizeof(data), text, sizeof(text), 0);
+	}), sizeof(data));
+	bench_report("b16_decode", bench_ns([&]() {
+		g_bench_sink += b16_decode(text, 2*sizeof(data), back, sizeof(back));
+	}), sizeof(data));
+}
+
+#ifdef LILLIB_CFG_CODING_X86_SIMD
+// Each vector level against plain C, from 1 KiB to 16 MiB (where it's all about memory bandwidth)
+BENCH(coding_x86)
+{
+	static const char *levels[] = { "C", "SSSE3", "AVX2" };
+	const int max = 16<<20;
+	uint8_t level;
+	static std::vector<uint8_t> data(max), text(b64_encode_size(max, 76)+1), back(max);
+	for (int i=0; i<max; i++) data[i] = (uint8_t)(i*167+13);
+	b64_encode((const char *)data.data(), 3, text.data(), 5, 0); // Sets the level from the CPU
+	level = b64_x86_level;
+	for (int n=1<<10; n<=max; n<<=2)
+	{
+		for (int linewidth : { 0, 76 })
+		{
+			int size = b64_encode_size(n, linewidth)+1;
+			for (int l=0; l<=level && l<3; l++)
+			{
+				char name[48];
+				b64_x86_level = l;
+				snprintf(name, sizeof(name), "b64_encode %-5s %8i %2i", levels[l], n, linewidth);
+				bench_report(name, bench_ns([&]() {
+					g_bench_sink += b64_encode((const char *)data.data(), n, text.data(), size, linewidth);
+				}), n);
+				snprintf(name, sizeof(name), "b64_decode %-5s %8i %2i", levels[l], n, linewidth);
+				bench_report(name, bench_ns([&]() {
+					g_bench_sink += b64_decode(text.data(), size-1, (char *)back.data(), n);
+				}), n);
+			}
+		}
+	}
+	b64_x86_level = level;
+}
+#endif
+
+BENCH(coding_z85)
+{
+	static uint8_t data[1024], back[1024];
+	static char text[2048];
+	for (int i=0; i<(int)sizeof(data); i++) data[i] = (uint8_t)(i*167+13);
+	int n = z85_encode(data, sizeof(data), text, sizeof(text), 0);
+	bench_report("z85_encode", bench_ns([&]() {
+		g_bench_sink += z85_encode(data, sizeof(data), text, sizeof(text), 0);
+	}), sizeof(data));
+	bench_report("z85_decode", bench_ns([&]() {
+		g_bench_sink += z85_decode(text, n, back, sizeof(back));
+	}), sizeof(data));
+}
+
+// COBS framing, for payloads with zeros as often as typical binary records have them, and none
+BENCH(coding_cobs)
+{
+	static uint8_t data[1024], framed[1100], back[1024];
+	for (int every : { 16, 0 })
+	{
+		char name[32];
+		for (int i=0; i<(int)sizeof(data); i++) data[i] = (every && i%every==0 ? 0 : (uint8_t)(i*167+13) | 1);
+		int n = cobs_encode(data, sizeof(data), framed, sizeof(framed));
+		snprintf(name, sizeof(name), "cobs_encode zero/%i", every);
+		bench_report(name, bench_ns([&]() {
+			g_bench_sink += cobs_encode(data, sizeof(data), framed, sizeof(framed));
+		}), sizeof(data));
+		snprintf(name, sizeof(name), "cobs_decode zero/%i", every);
+		bench_report(name, bench_ns([&]() {
+			g_bench_sink += cobs_decode(framed, n, back, sizeof(back));
+		}), sizeof(data));
+	}
+}
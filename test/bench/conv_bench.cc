@@ -0,0 +1,140 @@
+#include "bench.h"
+
+#include <stdlib.h>
+
+// ns per conversion for each specifier, through qsprintf (strf_sprint) and (for comparison) glibc's snprintf.  The
+// arguments cycle through a table so the branch predictors can't learn a single value.
+#define CONV_NVALS 64
+
+static int      g_ints[CONV_NVALS];
+static long     g_longs[CONV_NVALS];
+static long long g_llongs[CONV_NVALS];
+static double   g_doubles[CONV_NVALS];
+static const char *g_strs[CONV_NVALS];
+
+static void conv_bench_init()
+{
+	static const char *strs[] = { "", "a", "hello", "a somewhat longer string", "0123456789abcdef" };
+	uint64_t seed = 0x9E3779B97F4A7C15ULL;
+	for (int i=0; i<CONV_NVALS; i++)
+	{
+		seed = seed*6364136223846793005ULL + 1442695040888963407ULL;
+		// A spread of magnitudes, not just big numbers
+		g_llongs[i]  = (long long)seed >> (seed%60);
+		g_longs[i]   = (long)g_llongs[i];
+		g_ints[i]    = (int)g_llongs[i];
+		g_doubles[i] = (double)g_llongs[i] / (double)(1ULL<<(seed>>58));
+		g_strs[i]    = strs[i%5];
+	}
+}
+
+#define CONV_BENCH(what, fmt, vals) \
+	do { \
+		char buf[64]; \
+		unsigned i = 0; \
+		double ns = bench_ns([&]() { g_bench_sink += qsprintf(buf, sizeof(buf), fmt, vals[i++%CONV_NVALS]); }); \
+		double gns = bench_ns([&]() { g_bench_sink += snprintf(buf, sizeof(buf), fmt, vals[i++%CONV_NVALS]); }); \
+		printf("  %-32s %10.2f ns   (glibc %.2f ns)\n", what, ns, gns); \
+	} while (0)
+
+#define CONV_BENCH_STRF(what, fmt, vals) \
+	do { \
+		char buf[64]; \
+		unsigned i = 0; \
+		bench_report(what, bench_ns([&]() { g_bench_sink += qsprintf(buf, sizeof(buf), fmt, vals[i++%CONV_NVALS]); })); \
+	} while (0)
+
+BENCH(conv_sprint)
+{
+	conv_bench_init();
+	CONV_BENCH("%d",       "%d",       g_ints);
+	CONV_BENCH("%u",       "%u",       g_ints);
+	CONV_BENCH("%x",       "%x",       g_ints);
+	CONV_BENCH("%o",       "%o",       g_ints);
+	CONV_BENCH("%hhd",     "%hhd",     g_ints);
+	CONV_BENCH("%hd",      "%hd",      g_ints);
+	CONV_BENCH("%ld",      "%ld",      g_longs);
+	CONV_BENCH("%lld",     "%lld",     g_llongs);
+	CONV_BENCH("%llx",     "%llx",     g_llongs);
+	CONV_BENCH("%08x",     "%08x",     g_ints);
+	CONV_BENCH("%-12d",    "%-12d",    g_ints);
+	CONV_BENCH_STRF("%b",  "%b",       g_ints);
+	CONV_BENCH_STRF("%$",  "%$",       g_ints);
+	CONV_BENCH_STRF("%.3$", "%.3$",    g_ints);
+	CONV_BENCH_STRF("%k",  "%k",       g_ints);
+	CONV_BENCH("%s",       "%s",       g_strs);
+	CONV_BENCH("%20s",     "%20s",     g_strs);
+	CONV_BENCH("%c",       "%c",       g_ints);
+	CONV_BENCH("%f",       "%f",       g_doubles);
+	CONV_BENCH("%.2f",     "%.2f",     g_doubles);
+	CONV_BENCH("%e",       "%e",       g_doubles);
+	CONV_BENCH("%g",       "%g",       g_doubles);
+	CONV_BENCH("%.15g",    "%.15g",    g_doubles);
+}
+
+static void print_va(strf_putc putc, const char *fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	strf_print(putc, fmt, args);
+	va_end(args);
+}
+
+static void print_bulk_va(strf_write write, const char *fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	strf_print_bulk(write, fmt, args);
+	va_end(args);
+}
+
+BENCH(conv_print)
+{
+	// The same conversion through each of the output paths
+	conv_bench_init();
+	char buf[64];
+	unsigned i = 0;
+	const char *fmt = "x=%d y=%08x s=%s\n";
+	auto put = [](char c) { g_bench_sink += c; };
+	auto write = [](const char *s, int n, char c) { g_bench_sink += (s ? s[n-1] : c) + n; };
+	bench_report("qsprintf",        bench_ns([&]() { unsigned j = i++%CONV_NVALS; g_bench_sink += qsprintf(buf, sizeof(buf), fmt, g_ints[j], g_ints[j], g_strs[j]); }));
+	bench_report("strf_print",      bench_ns([&]() { unsigned j = i++%CONV_NVALS; print_va(put, fmt, g_ints[j], g_ints[j], g_strs[j]); }));
+	bench_report("strf_print_bulk", bench_ns([&]() { unsigned j = i++%CONV_NVALS; print_bulk_va(write, fmt, g_ints[j], g_ints[j], g_strs[j]); }));
+	bench_report("glibc snprintf",  bench_ns([&]() { unsigned j = i++%CONV_NVALS; g_bench_sink += snprintf(buf, sizeof(buf), fmt, g_ints[j], g_ints[j], g_strs[j]); }));
+	// Mostly literal text
+	char lbuf[128];
+	const char *lfmt = "sensor 3 temperature reading: %d tenths of a degree, humidity: %d percent\n";
+	bench_report("qsprintf, long literals",        bench_ns([&]() { unsigned j = i++%CONV_NVALS; g_bench_sink += qsprintf(lbuf, sizeof(lbuf), lfmt, g_ints[j]&0x3FF, g_ints[j]&0x3F); }));
+	bench_report("strf_print_bulk, long literals", bench_ns([&]() { unsigned j = i++%CONV_NVALS; print_bulk_va(write, lfmt, g_ints[j]&0x3FF, g_ints[j]&0x3F); }));
+	bench_report("glibc snprintf, long literals",  bench_ns([&]() { unsigned j = i++%CONV_NVALS; g_bench_sink += snprintf(lbuf, sizeof(lbuf), lfmt, g_ints[j]&0x3FF, g_ints[j]&0x3F); }));
+}
+
+BENCH(conv_itoa)
+{
+	conv_bench_init();
+	char buf[80];
+	unsigned i = 0;
+	bench_report("itoa2 radix 10",    bench_ns([&]() { g_bench_sink += *itoa2(buf+sizeof(buf), g_ints[i++%CONV_NVALS], 10, ITOA2_SIGNED); }));
+	bench_report("itoa2 radix 16",    bench_ns([&]() { g_bench_sink += *itoa2(buf+sizeof(buf), g_ints[i++%CONV_NVALS], 16, 0); }));
+	bench_report("itoa2 radix 7",     bench_ns([&]() { g_bench_sink += *itoa2(buf+sizeof(buf), g_ints[i++%CONV_NVALS], 7, 0); }));
+	bench_report("itoa2_8 radix 10",  bench_ns([&]() { g_bench_sink += *itoa2_8(buf+sizeof(buf), g_ints[i++%CONV_NVALS], 10, 0); }));
+	bench_report("itoa2_64 radix 10", bench_ns([&]() { g_bench_sink += *itoa2_64(buf+sizeof(buf), g_llongs[i++%CONV_NVALS], 10, ITOA2_SIGNED); }));
+	bench_report("itoa2_64 radix 16", bench_ns([&]() { g_bench_sink += *itoa2_64(buf+sizeof(buf), g_llongs[i++%CONV_NVALS], 16, 0); }));
+}
+
+BENCH(conv_strtol)
+{
+	conv_bench_init();
+	char strs[CONV_NVALS][24];
+	const char *end;
+	unsigned i = 0;
+	for (int j=0; j<CONV_NVALS; j++) snprintf(strs[j], sizeof(strs[j]), "%d", g_ints[j]);
+	bench_report("qstrtol radix 10", bench_ns([&]() { g_bench_sink += qstrtol(strs[i++%CONV_NVALS], &end, 10); }));
+	bench_report("qstrtol radix 0",  bench_ns([&]() { g_bench_sink += qstrtol(strs[i++%CONV_NVALS], &end, 0); }));
+	bench_report("strtol_b10",       bench_ns([&]() { g_bench_sink += strtol_b10(strs[i++%CONV_NVALS], &end); }));
+	bench_report("strtol_b10u",      bench_ns([&]() { const char *s = strs[i++%CONV_NVALS]; g_bench_sink += strtol_b10u(s+(*s=='-'), &end); }));
+	bench_report("glibc strtol",     bench_ns([&]() { g_bench_sink += strtol(strs[i++%CONV_NVALS], NULL, 10); }));
+	for (int j=0; j<CONV_NVALS; j++) snprintf(strs[j], sizeof(strs[j]), "%.3f", g_ints[j]/1000.0);
+	bench_report("strtofix %.3f",    bench_ns([&]() { g_bench_sink += strtofix(strs[i++%CONV_NVALS], &end, 3); }));
+	bench_report("strtofix_q %.3f",  bench_ns([&]() { g_bench_sink += strtofix_q(strs[i++%CONV_NVALS], &end, 16); }));
+}
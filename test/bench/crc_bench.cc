@@ -0,0 +1,23 @@
+#include "bench.h"
+
+BENCH(crc)
+{
+	static uint8_t data[4096];
+	for (int i=0; i<(int)sizeof(data); i++) data[i] = (uint8_t)(i*131+7);
+	for (int n : { 16, 256, 4096 })
+	{
+		char name[48];
+		snprintf(name, sizeof(name), "crc16_ccitt_update  %5i", n);
+		bench_report(name, bench_ns([&]() { g_bench_sink += crc16_ccitt_update(CRC16_CCITT_INIT, data, n); }), n);
+		snprintf(name, sizeof(name), "crc16_ccitt_nibble  %5i", n);
+		bench_report(name, bench_ns([&]() { g_bench_sink += crc16_ccitt_nibble(CRC16_CCITT_INIT, data, n); }), n);
+		snprintf(name, sizeof(name), "crc16_modbus_update %5i", n);
+		bench_report(name, bench_ns([&]() { g_bench_sink += crc16_modbus_update(CRC16_MODBUS_INIT, data, n); }), n);
+		snprintf(name, sizeof(name), "crc16_modbus_nibble %5i", n);
+		bench_report(name, bench_ns([&]() { g_bench_sink += crc16_modbus_nibble(CRC16_MODBUS_INIT, data, n); }), n);
+		snprintf(name, sizeof(name), "crc32_update        %5i", n);
+		bench_report(name, bench_ns([&]() { g_bench_sink += crc32_update(CRC32_INIT, data, n); }), n);
+		snprintf(name, sizeof(name), "crc32_nibble        %5i", n);
+		bench_report(name, bench_ns([&]() { g_bench_sink += crc32_nibble(CRC32_INIT, data, n); }), n);
+	}
+}
@@ -0,0 +1,43 @@
+#include "bench.h"
+
+#include <stdlib.h>
+
+// Compression ratio and speed on log text: a capture named by $LZSS_BENCH_LOG (e.g. of com output), or else
+// lines like the nodes' sensor logs
+BENCH(lzss)
+{
+	std::vector<uint8_t> log;
+	const char *path = getenv("LZSS_BENCH_LOG");
+	FILE *f = (path ? fopen(path, "rb") : NULL);
+	if (f)
+	{
+		int c;
+		while ((c=fgetc(f))!=EOF) log.push_back(c);
+		fclose(f);
+	}
+	else
+	{
+		char line[80];
+		srand(47);
+		for (int i=0; log.size()<64*1024; i++)
+		{
+			int k = snprintf(line, sizeof(line), "t=%i.%02i id=%04X temp=%i.%i rh=%i%% %s\n", i/100, i%100,
+				0x1A2B+i%3, 20+rand()%3, rand()%10, 40+i%7, (rand()%5 ? "ok" : "retry"));
+			log.insert(log.end(), line, line+k);
+		}
+	}
+	int n = log.size();
+	std::vector<uint8_t> enc(LZSS_ENC_SIZE(n)), dec(n);
+	int k = lzss_encode(log.data(), n, enc.data(), enc.size());
+	printf("  %-32s %10i -> %i bytes, %.2f:1\n", (f ? path : "synthetic log"), n, k, (double)n/k);
+	bench_report("lzss_encode", bench_ns([&]() { g_bench_sink += lzss_encode(log.data(), n, enc.data(), enc.size()); }), n);
+	bench_report("lzss_decode", bench_ns([&]() { g_bench_sink += lzss_decode(enc.data(), k, dec.data(), n); }), n);
+	// Through the stream in 64 byte pieces, as from a formatter
+	bench_report("lzss_enc_update 64", bench_ns([&]() {
+		lzss_enc s;
+		uint8_t out[LZSS_ENC_SIZE(64)];
+		lzss_enc_init(&s);
+		for (int i=0; i<n; i+=64) g_bench_sink += lzss_enc_update(&s, log.data()+i, (n-i<64 ? n-i : 64), out, sizeof(out));
+		g_bench_sink += lzss_enc_final(&s, out, sizeof(out));
+	}), n);
+}
@@ -0,0 +1,41 @@
+#include "bench.h"
+
+#include <vector>
+
+volatile uintptr_t g_bench_sink;
+
+struct BenchEntry { const char *name; bench_fn fn; };
+
+static std::vector<BenchEntry> &bench_list()
+{
+	static std::vector<BenchEntry> list;
+	return list;
+}
+
+Bench::Bench(const char *name, bench_fn fn)
+{
+	bench_list().push_back({ name, fn });
+}
+
+void bench_report(const char *what, double ns, size_t bytes)
+{
+	if (bytes) printf("  %-32s %10.2f ns %10.1f MB/s\n", what, ns, bytes*1e3/ns);
+	else       printf("  %-32s %10.2f ns\n", what, ns);
+}
+
+// The library needs these from the device
+extern "C" void com_putc(char c) { g_bench_sink += c; }
+extern "C" char com_getc() { return 0; }
+
+int main(int argc, char **argv)
+{
+	for (const BenchEntry &b : bench_list())
+	{
+		bool run = (argc<2);
+		for (int i=1; i<argc; i++) run |= (strstr(b.name, argv[i])!=NULL);
+		if (!run) continue;
+		printf("%s\n", b.name);
+		b.fn();
+	}
+	return 0;
+}
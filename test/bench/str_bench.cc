@@ -0,0 +1,74 @@
+#include "bench.h"
+
+// Each primitive against libc, for a few size classes.  The operands are at varying offsets so neither
+// gets to always work aligned.
+static const int g_str_sizes[] = { 3, 8, 24, 64, 256, 4096 };
+
+#define STR_BENCH(what, n, call) \
+	do { \
+		char name[48]; \
+		unsigned i = 0; \
+		snprintf(name, sizeof(name), "%-8s %5i", what, n); \
+		bench_report(name, bench_ns([&]() { unsigned o = i++&7; (void)o; call; }), n); \
+	} while (0)
+
+BENCH(str_mem)
+{
+	static char a[4096+16], b[4096+16];
+	memset(a, 'a', sizeof(a));
+	for (int n : g_str_sizes)
+	{
+		STR_BENCH("qmemcpy", n, g_bench_sink += (uintptr_t)qmemcpy(b+o, a+(o^3), n));
+		STR_BENCH("memcpy",  n, g_bench_sink += (uintptr_t)memcpy(b+o, a+(o^3), n));
+		STR_BENCH("qmemset", n, g_bench_sink += (uintptr_t)qmemset(b+o, (char)o, n));
+		STR_BENCH("memset",  n, g_bench_sink += (uintptr_t)memset(b+o, (char)o, n));
+		memset(b, 'a', sizeof(b));
+		STR_BENCH("qmemcmp", n, g_bench_sink += qmemcmp(b+o, a+(o^3), n));
+		STR_BENCH("memcmp",  n, g_bench_sink += memcmp(b+o, a+(o^3), n));
+		STR_BENCH("qmemchr", n, g_bench_sink += (uintptr_t)qmemchr(a+o, 'x', n));
+		STR_BENCH("memchr",  n, g_bench_sink += (uintptr_t)memchr(a+o, 'x', n));
+	}
+}
+
+BENCH(str_str)
+{
+	static char s[4096+16];
+	for (int n : g_str_sizes)
+	{
+		memset(s, 'a', sizeof(s));
+		for (int o=0; o<8; o++) s[o+n] = 0;
+		STR_BENCH("qstrlen", n, g_bench_sink += qstrlen(s+o));
+		STR_BENCH("strlen",  n, g_bench_sink += strlen(s+o));
+		STR_BENCH("qstrchr", n, g_bench_sink += (uintptr_t)qstrchr(s+o, 'x'));
+		STR_BENCH("strchr",  n, g_bench_sink += (uintptr_t)strchr(s+o, 'x'));
+	}
+}
+
+BENCH(str_builder)
+{
+	// The same line built with strb and with qsprintf
+	char buf[64];
+	unsigned i = 0;
+	bench_report("strb", bench_ns([&]() {
+		strb b;
+		int v = i++;
+		strb_init(&b, buf, sizeof(buf));
+		strb_append_str(&b, "t=");
+		strb_append_fix(&b, v&0xFFF, 2);
+		strb_append_str(&b, " id=");
+		strb_append_hex(&b, v, 4);
+		strb_append_str(&b, " n=");
+		strb_append_int(&b, v&0xFF, 10, 3, ' ');
+		g_bench_sink += b.length;
+	}));
+	bench_report("StrBuf", bench_ns([&]() {
+		StrBuf<64> s;
+		int v = i++;
+		s.append_str("t=").append_fix(v&0xFFF, 2).append_str(" id=").append_hex(v, 4).append_str(" n=").append_int(v&0xFF, 10, 3);
+		g_bench_sink += s.len();
+	}));
+	bench_report("qsprintf", bench_ns([&]() {
+		int v = i++;
+		g_bench_sink += qsprintf(buf, sizeof(buf), "t=%.2$ id=%04X n=%3i", v&0xFFF, v&0xFFFF, v&0xFF);
+	}));
+}
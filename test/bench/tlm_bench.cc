@@ -0,0 +1,42 @@
+#include "bench.h"
+
+// A sensor record as telemetry, against the same values as text
+BENCH(tlm)
+{
+	uint8_t buf[64];
+	char text[96];
+	unsigned i = 0;
+	tlm_enc t;
+	tlm_init(&t);
+	int n = qsprintf(text, sizeof(text), "t=%lu id=%04X temp=%.2$ rh=%.1$ v=%.3$ n=%i\n", 123456ul, 0x1A2B, 2150, 452, 3301, 17);
+	tlm_begin(&t, buf, sizeof(buf));
+	tlm_int(tlm_fix(tlm_fix(tlm_fix(tlm_uint(tlm_uint(&t, 1, 123456), 2, 0x1A2B), 3, 2150, 2), 4, 452, 1), 5, 3301, 3), 6, 17);
+	printf("  %-32s %10i bytes, text %i\n", "record", tlm_end(&t), n);
+	bench_report("tlm", bench_ns([&]() {
+		int v = i++;
+		tlm_begin(&t, buf, sizeof(buf));
+		tlm_uint(&t, 1, 123456+v);
+		tlm_uint(&t, 2, 0x1A2B);
+		tlm_fix(&t, 3, 2150+(v&7), 2);
+		tlm_fix(&t, 4, 452+(v&3), 1);
+		tlm_fix(&t, 5, 3301-(v&15), 3);
+		tlm_int(&t, 6, v&0xFF);
+		g_bench_sink += tlm_end(&t);
+	}));
+	bench_report("tlm deltas", bench_ns([&]() {
+		int v = i++;
+		tlm_begin(&t, buf, sizeof(buf));
+		tlm_int_delta(&t, 1, 123456+v);
+		tlm_uint(&t, 2, 0x1A2B);
+		tlm_fix_delta(&t, 3, 2150+(v&7), 2);
+		tlm_fix_delta(&t, 4, 452+(v&3), 1);
+		tlm_fix_delta(&t, 5, 3301-(v&15), 3);
+		tlm_int_delta(&t, 6, v&0xFF);
+		g_bench_sink += tlm_end(&t);
+	}));
+	bench_report("qsprintf", bench_ns([&]() {
+		int v = i++;
+		g_bench_sink += qsprintf(text, sizeof(text), "t=%lu id=%04X temp=%.2$ rh=%.1$ v=%.3$ n=%i\n",
+			123456ul+v, 0x1A2B, 2150+(v&7), 452+(v&3), 3301-(v&15), v&0xFF);
+	}));
+}
@@ -0,0 +1,408 @@
+#include "main.h"
+
+TEST(CodingTest, hexdump_line) {
+	const uint8_t data[] = { 0x00, 0x41, 0x7F, 0xFF, 0x20, 0x7A, 0x10, 0x80, 0x31 };
+	char line[HEXDUMP_LINE_SIZE(8)];
+	EXPECT_EQ(hexdump_line(line, 0x12, data, 4, 4, 0, 0), 13);
+	EXPECT_STREQ(line, " 00 41 7F FF\n");
+	hexdump_line(line, 0x12, data, 8, 8, 4, HEXDUMP_ADDR(4));
+	EXPECT_STREQ(line, "0012 : 00 41 7F FF  20 7A 10 80\n");
+	hexdump_line(line, 0x1234567, data, 8, 8, 2, HEXDUMP_ADDR(3)|HEXDUMP_ASCII);
+	EXPECT_STREQ(line, "567 : 00 41  7F FF  20 7A  10 80  .A.. z..\n");
+	// Short lines pad if there's an ASCII column
+	hexdump_line(line, 0xFFFFFFFF, data, 3, 8, 4, HEXDUMP_ADDR(8)|HEXDUMP_ASCII);
+	EXPECT_EQ(std::string(line), "FFFFFFFF : 00 41 7F" + std::string(18, ' ') + ".A.\n");
+	hexdump_line(line, 0, data, 3, 8, 4, 0);
+	EXPECT_STREQ(line, " 00 41 7F\n");
+	// And the buffer size is enough for the longest line
+	memset(line, '@', sizeof(line));
+	EXPECT_LT(hexdump_line(line, 0, data, 8, 8, 1, HEXDUMP_ADDR(8)|HEXDUMP_ASCII), (int)sizeof(line));
+	// Even with more address digits than a 32 bit address has
+	char big[HEXDUMP_LINE_SIZE(8)+16];
+	memset(big, '@', sizeof(big));
+	hexdump_line(line, 0xABCDEF12, data, 8, 8, 1, HEXDUMP_ADDR(8)|HEXDUMP_ASCII);
+	EXPECT_EQ(hexdump_line(big, 0xABCDEF12, data, 8, 8, 1, HEXDUMP_ADDR(15)|HEXDUMP_ASCII), (int)strlen(line));
+	EXPECT_STREQ(big, line);
+	EXPECT_EQ(big[sizeof(line)], '@');
+}
+
+static void hexdump_test_read(uint32_t addr, uint8_t *buf, uint8_t n)
+{
+	while (n--) *buf++ = (uint8_t)(addr++ * 3);
+}
+
+TEST(CodingTest, com_hexdump) {
+	std::vector<char> out;
+	uint8_t data[20];
+	for (int i=0; i<20; i++) data[i] = (uint8_t)(i*3 + 0x100*3);
+	g_com_putc_data = &out;
+	com_hexdump_stream(0x100, 20, hexdump_test_read, 8, 0, HEXDUMP_ADDR(3));
+	std::string a(out.begin(), out.end());
+	out.clear();
+	com_hexdump(0x100, data, 20, 8, 0, HEXDUMP_ADDR(3));
+	std::string b(out.begin(), out.end());
+	out.clear();
+	com_print_buf("buf", data, 4, 0);
+	std::string c(out.begin(), out.end());
+	out.clear();
+	com_print_buf("buf", data, 4, 2);
+	std::string d(out.begin(), out.end());
+	g_com_putc_data = nullptr;
+	EXPECT_EQ(a, "100 : 00 03 06 09 0C 0F 12 15\n108 : 18 1B 1E 21 24 27 2A 2D\n110 : 30 33 36 39\n");
+	EXPECT_EQ(a, b);
+	EXPECT_EQ(c, "buf : 00 03 06 09\n");
+	EXPECT_EQ(d, "buf :\n000 : 00 03\n002 : 06 09\n");
+}
+
+TEST(CodingTest, b16) {
+	const uint8_t data[] = { 0x00, 0x1F, 0xA5, 0xFF, 0x42 };
+	char text[32];
+	uint8_t out[8];
+	EXPECT_EQ(b16_encode(data, 5, text, sizeof(text), 0), 10);
+	EXPECT_STREQ(text, "001FA5FF42");
+	EXPECT_EQ(b16_encode(data, 5, text, sizeof(text), 4), 12);
+	EXPECT_STREQ(text, "001F\nA5FF\n42");
+	EXPECT_EQ(b16_decode("001fA5ff42", -1, out, sizeof(out)), 5);
+	EXPECT_EQ(memcmp(out, data, 5), 0);
+	// Whitespace anywhere is skipped, anything else ends it, as does isize, osize or an odd digit
+	EXPECT_EQ(b16_decode(" 0 01F\r\nA\t5FF42", -1, out, sizeof(out)), 5);
+	EXPECT_EQ(memcmp(out, data, 5), 0);
+	EXPECT_EQ(b16_decode("001FG5FF", -1, out, sizeof(out)), 2);
+	EXPECT_EQ(b16_decode("001FA5FF", 5, out, sizeof(out)), 2);
+	EXPECT_EQ(b16_decode("001FA5FF", -1, out, 3), 3);
+	EXPECT_EQ(b16_decode("001FA", -1, out, sizeof(out)), 2);
+}
+
+TEST(CodingTest, b64) {
+	// The RFC 4648 test vectors, wrapped and not
+	const char *plain[] = { "", "f", "fo", "foo", "foob", "fooba", "foobar" };
+	const char *coded[] = { "", "Zg==", "Zm8=", "Zm9v", "Zm9vYg==", "Zm9vYmE=", "Zm9vYmFy" };
+	const char *wrapped[] = { "", "Zg=\n=", "Zm8\n=", "Zm9\nv", "Zm9\nvYg\n==", "Zm9\nvYm\nE=", "Zm9\nvYm\nFy" };
+	char text[32], out[16];
+	for (int i=0; i<7; i++)
+	{
+		int n = strlen(plain[i]);
+		EXPECT_EQ(b64_encode(plain[i], n, (uint8_t *)text, sizeof(text), 0), (int)strlen(coded[i]));
+		EXPECT_STREQ(text, coded[i]);
+		EXPECT_EQ(b64_encode(plain[i], n, (uint8_t *)text, sizeof(text), 3), (int)strlen(wrapped[i]));
+		EXPECT_STREQ(text, wrapped[i]);
+		EXPECT_EQ(b64_decode((const uint8_t *)coded[i], -1, out, sizeof(out)), n);
+		EXPECT_EQ(std::string(out, n), plain[i]);
+		EXPECT_EQ(b64_decode((const uint8_t *)wrapped[i], -1, out, sizeof(out)), n);
+		EXPECT_EQ(std::string(out, n), plain[i]);
+	}
+	// Output stops at osize, without a NUL when it's full
+	memset(text, '@', sizeof(text));
+	EXPECT_EQ(b64_encode("foobar", 6, (uint8_t *)text, 6, 0), 6);
+	EXPECT_EQ(std::string(text, 7), "Zm9vYm@");
+	EXPECT_EQ(b64_decode((const uint8_t *)"Zm9vYmFy", -1, out, 4), 4);
+	EXPECT_EQ(std::string(out, 4), "foob");
+	// Whitespace is skipped, '=' or anything else ends it, as does isize, and a partial group gives what it has
+	EXPECT_EQ(b64_decode((const uint8_t *)" Zm 9v\r\nYm\tFy", -1, out, sizeof(out)), 6);
+	EXPECT_EQ(std::string(out, 6), "foobar");
+	EXPECT_EQ(b64_decode((const uint8_t *)"Zm9v*mFy", -1, out, sizeof(out)), 3);
+	EXPECT_EQ(b64_decode((const uint8_t *)"Zm9vYmFy", 6, out, sizeof(out)), 4);
+	EXPECT_EQ(b64_decode((const uint8_t *)"Zm9vYmF", -1, out, sizeof(out)), 5);
+	EXPECT_EQ(b64_decode((const uint8_t *)"Zm9vY\xFFmFy", -1, out, sizeof(out)), 3);
+	// All byte values round trip
+	uint8_t all[256];
+	char all_text[360], all_out[256];
+	for (int i=0; i<256; i++) all[i] = i;
+	EXPECT_EQ(b64_encode((const char *)all, 256, (uint8_t *)all_text, sizeof(all_text), 76), b64_encode_size(256, 76));
+	EXPECT_EQ(b64_decode((const uint8_t *)all_text, -1, all_out, sizeof(all_out)), 256);
+	EXPECT_EQ(memcmp(all, all_out, 256), 0);
+}
+
+#ifdef LILLIB_CFG_CODING_X86_SIMD
+TEST(CodingTest, b64_x86) {
+	// Each vector level against plain C, for lengths around the block sizes, with and without wrapping, and
+	// with whitespace, padding and invalid chars in the input
+	uint8_t level, tmp[8];
+	std::vector<uint8_t> data(300), coded[3], decoded[3];
+	b64_encode("abc", 3, tmp, sizeof(tmp), 0); // Sets the level from the CPU, which caps the ones tried
+	level = b64_x86_level;
+	srand(1);
+	for (auto &v : data) v = rand();
+	for (int len : { 0, 11, 12, 16, 27, 28, 29, 95, 96, 100, 299 })
+	{
+		for (int linewidth : { 0, 1, 4, 17, 64, 76 })
+		{
+			for (int osize : { 37, b64_encode_size(len, linewidth), 1000 })
+			{
+				for (int l=0; l<=level && l<3; l++)
+				{
+					b64_x86_level = l;
+					coded[l].assign(1001, 0xEE);
+					coded[l].resize(b64_encode((const char *)data.data(), len, coded[l].data(), osize, linewidth) + 1);
+					ASSERT_EQ(coded[l], coded[0]) << "level " << l << " len " << len << " linewidth " << linewidth << " osize " << osize;
+				}
+			}
+			std::string text((char *)coded[0].data());
+			for (int bad=0; bad<5; bad++)
+			{
+				std::string in = text;
+				if (bad==1 && in.size()>40) in[40] = '*';
+				if (bad==2 && in.size()>70) in.insert(70, " \r\n");
+				if (bad==3 && in.size()>50) in[50] = '=';
+				if (bad==4 && in.size()>33) in[33] = '\xC1';
+				for (int isize : { -1, (int)in.size(), (int)in.size()/2 })
+				{
+					for (int osize : { 300, len, len/3 })
+					{
+						for (int l=0; l<=level && l<3; l++)
+						{
+							b64_x86_level = l;
+							decoded[l].assign(301, 0xEE);
+							decoded[l].resize(b64_decode((const uint8_t *)in.data(), isize, (char *)decoded[l].data(), osize));
+							ASSERT_EQ(decoded[l], decoded[0]) << "level " << l << " in " << in << " isize " << isize << " osize " << osize;
+						}
+						if (bad==0 && isize==-1 && osize>=len)
+						{
+							ASSERT_EQ(decoded[0], std::vector<uint8_t>(data.begin(), data.begin()+len));
+						}
+					}
+				}
+			}
+		}
+	}
+	b64_x86_level = level;
+}
+#endif
+
+TEST(CodingTest, inplace) {
+	// Decoding over the input gives what decoding to another buffer does, with whitespace, bad chars and odd
+	// digits, and at each vector level, and leaves the rest of the buffer alone
+	uint8_t data[256];
+	char text[800], buf[800], ref[400];
+#ifdef LILLIB_CFG_CODING_X86_SIMD
+	b64_encode("abc", 3, data, sizeof(data), 0); // Sets the level from the CPU, which caps the ones tried
+#endif
+	srand(48);
+	for (auto &v : data) v = rand();
+	for (int len : { 0, 1, 2, 3, 12, 24, 37, 100, 185, 256 })
+	{
+		for (int linewidth : { 0, 5, 76 })
+		{
+			for (int bad=0; bad<4; bad++)
+			{
+				for (int b64=0; b64<2; b64++)
+				{
+					int k = (b64 ? b64_encode((const char *)data, len, (uint8_t *)text, sizeof(text), linewidth) :
+					                b16_encode(data, len, text, sizeof(text), linewidth));
+					if (bad==1 && k>30) text[30] = '*';
+					if (bad==2 && k>0) text[k-1] = 0, k--;
+					if (bad==3 && k>9) text[9] = ' ';
+					for (int isize : { -1, k, k/2 })
+					{
+#ifdef LILLIB_CFG_CODING_X86_SIMD
+						uint8_t level = b64_x86_level;
+						for (int l=0; l<=level && l<3; l++)
+						{
+							b64_x86_level = l;
+#endif
+							int n = (b64 ? b64_decode((const uint8_t *)text, isize, ref, sizeof(ref)) :
+							               b16_decode(text, isize, (uint8_t *)ref, sizeof(ref)));
+							memcpy(buf, text, sizeof(buf));
+							ASSERT_EQ(b64 ? b64_decode_inplace(buf, isize) : b16_decode_inplace(buf, isize), n)
+								<< b64 << " " << len << " " << linewidth << " " << bad << " " << isize;
+							ASSERT_EQ(memcmp(buf, ref, n), 0) << b64 << " " << len << " " << linewidth << " " << bad << " " << isize;
+							ASSERT_EQ(memcmp(buf+k, text+k, sizeof(buf)-k), 0);
+							if (!bad && isize!=k/2) { ASSERT_EQ(memcmp(buf, data, len), 0); }
+#ifdef LILLIB_CFG_CODING_X86_SIMD
+						}
+						b64_x86_level = level;
+#endif
+					}
+				}
+			}
+		}
+	}
+}
+
+TEST(CodingTest, stream) {
+	// Fed in pieces of every size, the streams give what the one-shot functions do
+	uint8_t data[100];
+	char text[500], chunked[500];
+	uint8_t back[100];
+	for (int i=0; i<(int)sizeof(data); i++) data[i] = i*37+5;
+	for (int len : { 0, 1, 2, 3, 4, 50, 100 })
+	{
+		for (int linewidth : { 0, 1, 7, 76 })
+		{
+			for (int chunk=1; chunk<=9; chunk++)
+			{
+				b64_enc e;
+				b64_dec d;
+				b16_enc e16;
+				b16_dec d16;
+				int n=0, k=0, tn = b64_encode((const char *)data, len, (uint8_t *)text, sizeof(text), linewidth);
+				b64_enc_init(&e, linewidth);
+				for (int i=0; i<len; i+=chunk) n += b64_enc_update(&e, data+i, std::min(chunk, len-i), chunked+n, sizeof(chunked)-n);
+				n += b64_enc_final(&e, chunked+n, sizeof(chunked)-n);
+				ASSERT_EQ(std::string(chunked, n), std::string(text, tn)) << "len " << len << " linewidth " << linewidth << " chunk " << chunk;
+				b64_dec_init(&d);
+				for (int i=0; i<n; i+=chunk) k += b64_dec_update(&d, chunked+i, std::min(chunk, n-i), back+k, sizeof(back)-k);
+				k += b64_dec_final(&d, back+k, sizeof(back)-k);
+				ASSERT_EQ(k, len);
+				ASSERT_EQ(memcmp(back, data, len), 0);
+				EXPECT_EQ(d.done, len%3!=0); // Stopped at the '='
+
+				n = 0, k = 0, tn = b16_encode(data, len, text, sizeof(text), linewidth);
+				b16_enc_init(&e16, linewidth);
+				for (int i=0; i<len; i+=chunk) n += b16_enc_update(&e16, data+i, std::min(chunk, len-i), chunked+n, sizeof(chunked)-n);
+				n += b16_enc_final(&e16, chunked+n, sizeof(chunked)-n);
+				ASSERT_EQ(std::string(chunked, n), std::string(text, tn));
+				b16_dec_init(&d16);
+				for (int i=0; i<n; i+=chunk) k += b16_dec_update(&d16, chunked+i, std::min(chunk, n-i), back+k, sizeof(back)-k);
+				k += b16_dec_final(&d16, back+k, sizeof(back)-k);
+				ASSERT_EQ(k, len);
+				ASSERT_EQ(memcmp(back, data, len), 0);
+			}
+		}
+	}
+	// A char at a time, as from com_getc, and nothing more once it has ended
+	b64_dec d;
+	uint8_t out[8];
+	int n = 0;
+	b64_dec_init(&d);
+	for (const char *s="Zm9v\r\nYmE=Zm9v"; *s; s++) n += b64_dec_update(&d, s, 1, out+n, sizeof(out)-n);
+	EXPECT_TRUE(d.done);
+	n += b64_dec_final(&d, out+n, sizeof(out)-n);
+	EXPECT_EQ(std::string((char *)out, n), "fooba");
+	b16_dec d16;
+	b16_dec_init(&d16);
+	EXPECT_EQ(b16_dec_update(&d16, "4", 1, out, 4), 0);
+	EXPECT_EQ(b16_dec_update(&d16, "1 4", 3, out, 4), 1);
+	EXPECT_EQ(b16_dec_update(&d16, "2.43", 4, out+1, 3), 1);
+	EXPECT_TRUE(d16.done);
+	EXPECT_EQ(b16_dec_final(&d16, out+2, 2), 0);
+	EXPECT_EQ(std::string((char *)out, 2), "AB");
+}
+
+TEST(CodingTest, z85) {
+	// The example from the spec
+	const uint8_t hello[] = { 0x86, 0x4F, 0xD2, 0x6F, 0xB5, 0x59, 0xF7, 0x5B };
+	char text[64];
+	uint8_t out[128];
+	EXPECT_EQ(z85_encode(hello, 8, text, sizeof(text), 0), 10);
+	EXPECT_STREQ(text, "HelloWorld");
+	EXPECT_EQ(z85_encode(hello, 8, text, sizeof(text), 4), 12);
+	EXPECT_STREQ(text, "Hell\noWor\nld");
+	EXPECT_EQ(z85_decode(" Hell\noWor\r\nld", -1, out, sizeof(out)), 8);
+	EXPECT_EQ(memcmp(out, hello, 8), 0);
+	// Partial groups, and the extremes of a group
+	uint8_t data[9] = { 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0xFF };
+	for (int len=0; len<=9; len++)
+	{
+		int n = z85_encode(data, len, text, sizeof(text), 0);
+		EXPECT_EQ(n, z85_encode_size(len, 0));
+		EXPECT_EQ(z85_decode(text, -1, out, sizeof(out)), len);
+		EXPECT_EQ(memcmp(out, data, len), 0) << len;
+	}
+	z85_encode(data, 4, text, sizeof(text), 0);
+	EXPECT_STREQ(text, "%nSc0");
+	// Anything else ends it, as does a group over 32 bits
+	EXPECT_EQ(z85_decode("HelloWor\"ld", -1, out, sizeof(out)), 6);
+	EXPECT_EQ(z85_decode("Hello%nSc1", -1, out, sizeof(out)), 4);
+	EXPECT_EQ(z85_decode("Hello#####", -1, out, sizeof(out)), 4);
+	EXPECT_EQ(z85_decode("Hello####", -1, out, sizeof(out)), 4);  // And a partial one, padded
+	EXPECT_EQ(z85_decode("Hello%nSc", -1, out, sizeof(out)), 4);
+	EXPECT_EQ(z85_decode("Hello%nSb", -1, out, sizeof(out)), 7);
+	EXPECT_EQ(z85_decode("HelloWorld", 7, out, sizeof(out)), 5);
+	EXPECT_EQ(z85_decode("HelloWorld", -1, out, 6), 6);
+	// Streamed in pieces of every size
+	uint8_t big[101];
+	char coded[200], chunked[200];
+	for (int i=0; i<(int)sizeof(big); i++) big[i] = i*53+7;
+	for (int chunk=1; chunk<=11; chunk++)
+	{
+		z85_enc e;
+		z85_dec d;
+		int n=0, k=0, tn = z85_encode(big, sizeof(big), coded, sizeof(coded), 30);
+		z85_enc_init(&e, 30);
+		for (int i=0; i<(int)sizeof(big); i+=chunk) n += z85_enc_update(&e, big+i, std::min(chunk, (int)sizeof(big)-i), chunked+n, sizeof(chunked)-n);
+		n += z85_enc_final(&e, chunked+n, sizeof(chunked)-n);
+		ASSERT_EQ(std::string(chunked, n), std::string(coded, tn));
+		ASSERT_EQ(n, z85_encode_size(sizeof(big), 30));
+		z85_dec_init(&d);
+		for (int i=0; i<n; i+=chunk) k += z85_dec_update(&d, chunked+i, std::min(chunk, n-i), out+k, sizeof(out)-k);
+		ASSERT_FALSE(d.done);
+		k += z85_dec_final(&d, out+k, sizeof(out)-k);
+		ASSERT_EQ(k, (int)sizeof(big));
+	}
+}
+
+TEST(CodingTest, cobs) {
+	// The examples from the COBS paper/Wikipedia, including the runs around 254 bytes
+	auto seq = [](int from, int n) { std::vector<uint8_t> v; for (int i=0; i<n; i++) v.push_back((uint8_t)(from+i)); return v; };
+	auto cat = [](std::vector<uint8_t> a, const std::vector<uint8_t> &b) { a.insert(a.end(), b.begin(), b.end()); return a; };
+	struct { std::vector<uint8_t> plain, coded; } tests[] = {
+		{ {}, { 0x01 } },
+		{ { 0x00 }, { 0x01, 0x01 } },
+		{ { 0x00, 0x00 }, { 0x01, 0x01, 0x01 } },
+		{ { 0x00, 0x11, 0x00 }, { 0x01, 0x02, 0x11, 0x01 } },
+		{ { 0x11, 0x22, 0x00, 0x33 }, { 0x03, 0x11, 0x22, 0x02, 0x33 } },
+		{ { 0x11, 0x22, 0x33, 0x44 }, { 0x05, 0x11, 0x22, 0x33, 0x44 } },
+		{ { 0x11, 0x00, 0x00, 0x00 }, { 0x02, 0x11, 0x01, 0x01, 0x01 } },
+		{ seq(1, 254), cat({ 0xFF }, seq(1, 254)) },
+		{ seq(0, 255), cat({ 0x01, 0xFF }, seq(1, 254)) },
+		{ seq(1, 255), cat(cat({ 0xFF }, seq(1, 254)), { 0x02, 0xFF }) },
+		{ seq(2, 255), cat(cat({ 0xFF }, seq(2, 254)), { 0x01, 0x01 }) },
+		{ seq(3, 255), cat(cat({ 0xFE }, seq(3, 253)), { 0x02, 0x01 }) },
+	};
+	uint8_t buf[600];
+	for (auto &t : tests)
+	{
+		int n = cobs_encode(t.plain.data(), t.plain.size(), buf, cobs_encode_size(t.plain.size()));
+		ASSERT_EQ(std::vector<uint8_t>(buf, buf+std::max(n, 0)), t.coded) << t.plain.size();
+		n = cobs_decode(t.coded.data(), t.coded.size(), buf, t.plain.size());
+		ASSERT_EQ(std::vector<uint8_t>(buf, buf+std::max(n, 0)), t.plain) << t.plain.size();
+		// And with the delimiter, and anything after it
+		std::vector<uint8_t> framed = cat(t.coded, { 0x00, 0x05, 0x11 });
+		EXPECT_EQ(cobs_decode(framed.data(), framed.size(), buf, sizeof(buf)), (int)t.plain.size());
+		if (t.plain.size())
+		{
+			EXPECT_EQ(cobs_decode(t.coded.data(), t.coded.size(), buf, t.plain.size()-1), -1);
+		}
+		// And fed in pieces, which split the runs
+		for (int piece : { 1, 2, 7, 100 })
+		{
+			cobs_dec d;
+			int k = 0;
+			cobs_dec_init(&d);
+			for (size_t i=0; i<framed.size(); i+=piece)
+				k += cobs_dec_update(&d, framed.data()+i, std::min(piece, (int)(framed.size()-i)), buf+k, sizeof(buf)-k);
+			EXPECT_TRUE(d.done && !d.error);
+			EXPECT_EQ(std::vector<uint8_t>(buf, buf+k), t.plain) << t.plain.size() << " " << piece;
+		}
+	}
+	EXPECT_EQ(cobs_encode((const uint8_t *)"abc", 3, buf, 3), -1);
+	// A frame that ends inside a run
+	const uint8_t bad[] = { 0x05, 0x11, 0x22, 0x00 };
+	EXPECT_EQ(cobs_decode(bad, sizeof(bad), buf, sizeof(buf)), -1);
+	EXPECT_EQ(cobs_decode(bad, 3, buf, sizeof(buf)), -1);
+}
+
+TEST(CodingTest, com_packet) {
+	// Packets through com_putc and back through com_getc, with a malformed one in between
+	std::vector<char> line;
+	std::vector<uint8_t> a = { 0x00, 0x7F, 0x04, 0x80, 0xFF, 0x00 }, b(600, 0x55);
+	uint8_t buf[600];
+	g_com_putc_data = &line;
+	com_set_binary(1);
+	com_send_packet(a.data(), a.size());
+	line.insert(line.end(), { 0x05, 0x11, 0x00 });
+	com_send_packet(b.data(), b.size());
+	com_send_packet(b.data(), 0);
+	g_com_putc_data = nullptr;
+	EXPECT_EQ(std::count(line.begin(), line.end(), 0), 4);
+	std::reverse(line.begin(), line.end());
+	g_com_getc_data = &line;
+	EXPECT_EQ(com_recv_packet(buf, sizeof(buf)), (int)a.size());
+	EXPECT_EQ(std::vector<uint8_t>(buf, buf+a.size()), a);
+	EXPECT_EQ(com_recv_packet(buf, sizeof(buf)), -1);
+	EXPECT_EQ(com_recv_packet(buf, 100), -1); // Too long, but read to its end
+	EXPECT_EQ(com_recv_packet(buf, sizeof(buf)), 0);
+	EXPECT_TRUE(line.empty());
+	g_com_getc_data = nullptr;
+}
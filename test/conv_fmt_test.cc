@@ -1,4 +1,5 @@
 #include "main.h"
+#include <functional>
 
 struct PrintfHelper
 {
@@ -27,12 +28,74 @@ struct SprintfHelper
 		std::vector<char> data(1024, 0);
 		va_list args;
 		va_start(args, fmt);
-		strf_sprint(data.data(), data.size(), fmt, args);
+		int n = strf_sprint(data.data(), data.size(), fmt, args);
 		va_end(args);
+		EXPECT_EQ(n, (int)strlen(data.data()));
 		return std::string(data.data());
 	}
 };
 
+// The _P formatters, which on the host read "flash" as plain memory
+struct PrintfPHelper
+{
+	static std::string format(const char *fmt, ...)
+	{
+		PrintfHelper::putc_data.clear();
+		va_list args;
+		va_start(args, fmt);
+		strf_print_P(PrintfHelper::putc, fmt, args);
+		va_end(args);
+		return std::string(PrintfHelper::putc_data.data(), PrintfHelper::putc_data.size());
+	}
+};
+
+struct SprintfPHelper
+{
+	static std::string format(const char *fmt, ...)
+	{
+		std::vector<char> data(1024, 0);
+		va_list args;
+		va_start(args, fmt);
+		int n = strf_sprint_P(data.data(), data.size(), fmt, args);
+		va_end(args);
+		EXPECT_EQ(n, (int)strlen(data.data()));
+		return std::string(data.data());
+	}
+};
+
+// The bulk formatters, checking that they never pass empty spans
+struct PrintBulkHelper
+{
+	static std::string format(const char *fmt, ...)
+	{
+		PrintfHelper::putc_data.clear();
+		va_list args;
+		va_start(args, fmt);
+		strf_print_bulk(PrintBulkHelper::write, fmt, args);
+		va_end(args);
+		return std::string(PrintfHelper::putc_data.data(), PrintfHelper::putc_data.size());
+	}
+
+	static void write(const char *s, int n, char c)
+	{
+		EXPECT_GT(n, 0);
+		while (n-- > 0) PrintfHelper::putc(s ? *s++ : c);
+	}
+};
+
+struct PrintBulkPHelper
+{
+	static std::string format(const char *fmt, ...)
+	{
+		PrintfHelper::putc_data.clear();
+		va_list args;
+		va_start(args, fmt);
+		strf_print_bulk_P(PrintBulkHelper::write, fmt, args);
+		va_end(args);
+		return std::string(PrintfHelper::putc_data.data(), PrintfHelper::putc_data.size());
+	}
+};
+
 template <typename T>
 class ConvFmtTest : public testing::Test
 {
@@ -40,7 +103,7 @@ public:
 	using Helper = T;
 };
 
-using ConvFmtTestTypes = ::testing::Types<SprintfHelper, PrintfHelper>;
+using ConvFmtTestTypes = ::testing::Types<SprintfHelper, PrintfHelper, SprintfPHelper, PrintfPHelper, PrintBulkHelper, PrintBulkPHelper>;
 TYPED_TEST_SUITE(ConvFmtTest, ConvFmtTestTypes);
 
 
@@ -83,6 +146,20 @@ TYPED_TEST(ConvFmtTest, string) {
 	
 	EXPECT_EQ(TypeParam::format("x%/^*.*s%#^*.*sx", 10, 2, "abc", 8, 4, "xyz"), "x////ab////##xyz###x");
 	EXPECT_EQ(TypeParam::format("x%/^*.*s%#>*.*sx", 3, 4, "abc", 3, 2, "xyz"), "xabc#xyx");
+
+	// Flash strings
+	EXPECT_EQ(TypeParam::format("%S", PSTR("abc")), "abc");
+	EXPECT_EQ(TypeParam::format("x%/^10.2Sx", PSTR("abc")), "x////ab////x");
+	EXPECT_EQ(TypeParam::format("%S%s%S", PSTR("a"), "b", PSTR("")), "ab");
+}
+
+TEST(ConvFmtPTest, longspec) {
+	char buf[64];
+	// Specs are copied out of flash, so check one that fills the copy and that parsing resumes after it
+	qsprintf_P(buf, sizeof(buf), PSTR("[%#^12.00000000000000001i]x"), 5);
+	EXPECT_STREQ(buf, "[#####5######]x");
+	qsprintf(buf, sizeof(buf), FSTR("%i:%S"), 12, PSTR("ab"));
+	EXPECT_STREQ(buf, "12:ab");
 }
 
 TYPED_TEST(ConvFmtTest, ints) {
@@ -142,20 +219,156 @@ TYPED_TEST(ConvFmtTest, ints) {
 	EXPECT_EQ(TypeParam::format("x%+10.6$x", 1234), "x  +.001234x");
 }
 
+TYPED_TEST(ConvFmtTest, sizes) {
+	// hh: 8 bits, so values are truncated and signed conversions sign extend from bit 7
+	EXPECT_EQ(TypeParam::format("x%hhix", 127), "x127x");
+	EXPECT_EQ(TypeParam::format("x%hhix", 128), "x-128x");
+	EXPECT_EQ(TypeParam::format("x%hhix", -1), "x-1x");
+	EXPECT_EQ(TypeParam::format("x%hhux", -1), "x255x");
+	EXPECT_EQ(TypeParam::format("x%hhux", 0x1234), "x52x");
+	EXPECT_EQ(TypeParam::format("x%hhXx", 0xABCD), "xCDx");
+	EXPECT_EQ(TypeParam::format("x%hhbx", -1), "x11111111x");
+	EXPECT_EQ(TypeParam::format("x%hhox", 0x1FF), "x377x");
+	EXPECT_EQ(TypeParam::format("x%05hhix", -5), "x-0005x");
+	EXPECT_EQ(TypeParam::format("x%.1hh$x", -123), "x-12.3x");
+
+	// h: 16 bits
+	EXPECT_EQ(TypeParam::format("x%hix", 32767), "x32767x");
+	EXPECT_EQ(TypeParam::format("x%hix", 32768), "x-32768x");
+	EXPECT_EQ(TypeParam::format("x%hux", -1), "x65535x");
+	EXPECT_EQ(TypeParam::format("x%hux", 0x12345), "x9029x");
+	EXPECT_EQ(TypeParam::format("x%hxx", 0xDEADBEEF), "xbeefx");
+	EXPECT_EQ(TypeParam::format("x%-8hix", -1234), "x-1234   x");
+
+	// l: long
+	EXPECT_EQ(TypeParam::format("x%lix", 2147483647L), "x2147483647x");
+	EXPECT_EQ(TypeParam::format("x%lix", -2147483647L-1), "x-2147483648x");
+	EXPECT_EQ(TypeParam::format("x%lux", 4294967295UL), "x4294967295x");
+	EXPECT_EQ(TypeParam::format("x%lXx", 0xDEADBEEFUL), "xDEADBEEFx");
+	EXPECT_EQ(TypeParam::format("x%010lix", -123456789L), "x-123456789x");
+	EXPECT_EQ(TypeParam::format("x%.3l$x", 123456789L), "x123456.789x");
+	if (sizeof(long)==8)
+	{
+		EXPECT_EQ(TypeParam::format("x%lux", 18446744073709551615UL), "x18446744073709551615x");
+		EXPECT_EQ(TypeParam::format("x%lix", -9223372036854775807L-1), "x-9223372036854775808x");
+	}
+
+	// ll: 64 bits
+	EXPECT_EQ(TypeParam::format("x%llix", 9223372036854775807LL), "x9223372036854775807x");
+	EXPECT_EQ(TypeParam::format("x%llix", -9223372036854775807LL-1), "x-9223372036854775808x");
+	EXPECT_EQ(TypeParam::format("x%llux", 18446744073709551615ULL), "x18446744073709551615x");
+	EXPECT_EQ(TypeParam::format("x%llxx", 0x0123456789ABCDEFULL), "x123456789abcdefx");
+	EXPECT_EQ(TypeParam::format("x%llbx", 0x8000000000000001ULL), "x1000000000000000000000000000000000000000000000000000000000000001x");
+	EXPECT_EQ(TypeParam::format("x%+24llix", 1234567890123456789LL), "x    +1234567890123456789x");
+	EXPECT_EQ(TypeParam::format("x%.4ll$x", -12345678901234LL), "x-1234567890.1234x");
+
+	// Sizes must consume the right amount from the argument list
+	EXPECT_EQ(TypeParam::format("%hhi %lli %hi %li %i", 1, 2LL, 3, 4L, 5), "1 2 3 4 5");
+}
+
 TYPED_TEST(ConvFmtTest, floats) {
-	// Nothing is supported, since float support on current platforms isn't needed
-	EXPECT_EQ(TypeParam::format("x%fx", 12.34), "x<float?>x");
-	EXPECT_EQ(TypeParam::format("x%Fx", 12.34), "x<float?>x");
-	EXPECT_EQ(TypeParam::format("x%ex", 12.34), "x<float?>x");
-	EXPECT_EQ(TypeParam::format("x%Ex", 12.34), "x<float?>x");
-	EXPECT_EQ(TypeParam::format("x%gx", 12.34), "x<float?>x");
-	EXPECT_EQ(TypeParam::format("x%Gx", 12.34), "x<float?>x");
+	EXPECT_EQ(TypeParam::format("x%fx", 12.34), "x12.340000x");
+	EXPECT_EQ(TypeParam::format("x%Fx", 12.34), "x12.340000x");
+	EXPECT_EQ(TypeParam::format("x%ex", 12.34), "x1.234000e+01x");
+	EXPECT_EQ(TypeParam::format("x%Ex", 12.34), "x1.234000E+01x");
+	EXPECT_EQ(TypeParam::format("x%gx", 12.34), "x12.34x");
+	EXPECT_EQ(TypeParam::format("x%Gx", 12.34e-9), "x1.234E-08x");
+	// Hex floats still aren't supported
 	EXPECT_EQ(TypeParam::format("x%ax", 12.34), "x<float?>x");
 	EXPECT_EQ(TypeParam::format("x%Ax", 12.34), "x<float?>x");
 
+	// Precision and rounding
+	EXPECT_EQ(TypeParam::format("x%.0fx", 12.34), "x12x");
+	EXPECT_EQ(TypeParam::format("x%.1fx", 12.35), "x12.3x"); // 12.35 is really 12.3499999...
+	EXPECT_EQ(TypeParam::format("x%.2fx", 0.125), "x0.12x");  // Exact ties go to even
+	EXPECT_EQ(TypeParam::format("x%.2fx", 0.375), "x0.38x");
+	EXPECT_EQ(TypeParam::format("x%.3fx", 9.9996), "x10.000x");
+	EXPECT_EQ(TypeParam::format("x%.10fx", 1.0/3), "x0.3333333333x");
+	EXPECT_EQ(TypeParam::format("x%.3fx", 0.0004), "x0.000x");
+	EXPECT_EQ(TypeParam::format("x%.3fx", 0.0005), "x0.001x");
+	EXPECT_EQ(TypeParam::format("x%.0ex", 9.5), "x1e+01x");
+	EXPECT_EQ(TypeParam::format("x%.3ex", 1e-300), "x1.000e-300x");
+	EXPECT_EQ(TypeParam::format("x%.3ex", 1.7976931348623157e308), "x1.798e+308x");
+	EXPECT_EQ(TypeParam::format("x%.16ex", 5e-324), "x4.9406564584124654e-324x");
+	EXPECT_EQ(TypeParam::format("x%.3gx", 1234567.0), "x1.23e+06x");
+	EXPECT_EQ(TypeParam::format("x%.3gx", 0.0001234), "x0.000123x");
+	EXPECT_EQ(TypeParam::format("x%.3gx", 0.00001234), "x1.23e-05x");
+	EXPECT_EQ(TypeParam::format("x%gx", 100000.0), "x100000x");
+	EXPECT_EQ(TypeParam::format("x%gx", 1000000.0), "x1e+06x");
+	EXPECT_EQ(TypeParam::format("x%.0gx", 0.5), "x0.5x");
+	EXPECT_EQ(TypeParam::format("x%fx", 1e20), "x100000000000000000000.000000x");
+	// Only the first 17 digits are significant, the rest are filled with 0
+	EXPECT_EQ(TypeParam::format("x%.0fx", 123456789012345678901234.0), "x123456789012345690000000x"); // ...685803008
+
+	// Zero, sign and specials
+	EXPECT_EQ(TypeParam::format("x%fx", 0.0), "x0.000000x");
+	EXPECT_EQ(TypeParam::format("x%ex", 0.0), "x0.000000e+00x");
+	EXPECT_EQ(TypeParam::format("x%gx", 0.0), "x0x");
+	EXPECT_EQ(TypeParam::format("x%fx", -0.0), "x-0.000000x");
+	EXPECT_EQ(TypeParam::format("x%+.1fx", 1.0), "x+1.0x");
+	EXPECT_EQ(TypeParam::format("x% .1fx", 1.0), "x 1.0x");
+	EXPECT_EQ(TypeParam::format("x%fx", 1.0/0.0), "xinfx");
+	EXPECT_EQ(TypeParam::format("x%Fx", -1.0/0.0), "x-INFx");
+	EXPECT_EQ(TypeParam::format("x%ex", __builtin_nan("")), "xnanx");
+
 	// The normal "string" aligns should work without special behavor (e.g for sign)
-	EXPECT_EQ(TypeParam::format("x%13fx", -12.34), "x     <float?>x");
-	EXPECT_EQ(TypeParam::format("x%@<13fx", -12.34), "x<float?>@@@@@x");
-	EXPECT_EQ(TypeParam::format("x%@^13fx", -12.34), "x@@<float?>@@@x");
-	EXPECT_EQ(TypeParam::format("x%@>13fx", -12.34), "x@@@@@<float?>x");
+	EXPECT_EQ(TypeParam::format("x%13fx", -12.34), "x   -12.340000x");
+	EXPECT_EQ(TypeParam::format("x%@<13fx", -12.34), "x-12.340000@@@x");
+	EXPECT_EQ(TypeParam::format("x%@^13fx", -12.34), "x@-12.340000@@x");
+	EXPECT_EQ(TypeParam::format("x%@>13fx", -12.34), "x@@@-12.340000x");
+	EXPECT_EQ(TypeParam::format("x%013.2fx", -12.34), "x-000000012.34x");
+
+	// Huge precisions are clamped to what fits the conversion buffer rather than overflowing it
+	EXPECT_EQ(TypeParam::format("%.200f", 1.5).substr(0, 6), "1.5000");
+	EXPECT_EQ(TypeParam::format("%.200e", 1.5).substr(0, 6), "1.5000");
+}
+
+TYPED_TEST(ConvFmtTest, qfixed) {
+	// Q16.16 fixed point
+	EXPECT_EQ(TypeParam::format("x%kx", 0x00018000), "x1.5000x");
+	EXPECT_EQ(TypeParam::format("x%.2kx", 0x00018000), "x1.50x");
+	EXPECT_EQ(TypeParam::format("x%.0kx", 0x00018000), "x2.x");
+	EXPECT_EQ(TypeParam::format("x%.9kx", 0x00010001), "x1.0000x");
+	EXPECT_EQ(TypeParam::format("x%.4kx", 0x0000FFFF), "x1.0000x");
+	EXPECT_EQ(TypeParam::format("x%.4kx", 0x00000004), "x.0001x");
+	EXPECT_EQ(TypeParam::format("x%kx", -0x00018000), "x-1.5000x");
+	EXPECT_EQ(TypeParam::format("x%kx", (int)0x80000000), "x-32768.0000x");
+	EXPECT_EQ(TypeParam::format("x%Kx", 0xFFFF0000), "x65535.0000x");
+	EXPECT_EQ(TypeParam::format("x%Kx", 0xFFFFFFFF), "x65536.0000x");
+	EXPECT_EQ(TypeParam::format("x%.3kx", 0x0003243F), "x3.142x");
+	EXPECT_EQ(TypeParam::format("x%010.2kx", -0x0003243F), "x-000003.14x");
+	EXPECT_EQ(TypeParam::format("x%+.1kx", 0x00020000), "x+2.0x");
+}
+
+TEST(ConvFmtSprintTest, truncation) {
+	// Every output size for fields with all of lpad, sign, cpad, content and rpad, checking the length
+	// returned, the output and that nothing past size was written
+	typedef int (*sprint_fn)(char *buf, int size, const char *fmt, ...);
+	static const sprint_fn fns[] = { qsprintf, qsprintf_P };
+	char full[64], buf[64];
+	for (sprint_fn fn : fns)
+	{
+		auto check = [&](std::function<int (char *, int)> f) {
+			int len = f(full, sizeof(full));
+			EXPECT_EQ(len, (int)strlen(full)) << full;
+			EXPECT_EQ(f(NULL, 0), len) << full;
+			EXPECT_EQ(f(NULL, 10), len) << full;
+			for (int size=0; size<=len+2; size++)
+			{
+				memset(buf, '@', sizeof(buf));
+				EXPECT_EQ(f(buf, size), len) << full << " " << size;
+				if (size)
+				{
+					EXPECT_EQ(std::string(buf), std::string(full, size-1<len ? size-1 : len)) << full << " " << size;
+				}
+				EXPECT_EQ(buf[size], '@') << full << " " << size;
+			}
+		};
+		check([&](char *b, int n) { return fn(b, n, "a%#^+9ib", -42); });
+		check([&](char *b, int n) { return fn(b, n, "%<6s.%s", "xyz", "uvw"); });
+		check([&](char *b, int n) { return fn(b, n, "x%+08.2$y", 12345); });
+		check([&](char *b, int n) { return fn(b, n, "%c%c|%3c|", 'q', 0, 0); });
+		check([&](char *b, int n) { return fn(b, n, "[%#^ 9.2k]", 0x18000); });
+		check([&](char *b, int n) { return fn(b, n, "%S%%", PSTR("flash")); });
+	}
 }
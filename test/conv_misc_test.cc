@@ -1,2 +1,252 @@
 #include "main.h"
+#include <climits>
 
+template <typename T>
+static std::string itoa2_ref(T v, int radix, uint8_t flags)
+{
+	const char *digits = ((flags&ITOA2_UCASE) ? "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ" : "0123456789abcdefghijklmnopqrstuvwxyz");
+	bool n = (flags&ITOA2_SIGNED) && (v>>(8*sizeof(T)-1));
+	std::string r;
+	if (n) v = -v;
+	do { r.insert(r.begin(), digits[v%radix]); v /= radix; } while (v);
+	if (n && !(flags&ITOA2_NOSIGN)) r.insert(r.begin(), '-');
+	return r;
+}
+
+TEST(ConvMiscTest, itoa2) {
+	char buf[34];
+	const unsigned int values[] = {
+		0, 1, 9, 10, 99, 100, 255, 256, 999, 1000, 9999, 10000, 32767, 32768, 65535, 65536,
+		99999, 100000, 1234567, 0x7FFFFFFF, 0x80000000, 0xFFFFFFFF, (unsigned int)-1234,
+	};
+	for (int radix=2; radix<=36; radix++)
+	{
+		for (unsigned int v : values)
+		{
+			for (uint8_t flags : {0, ITOA2_UCASE, ITOA2_SIGNED, ITOA2_SIGNED|ITOA2_NOSIGN})
+			{
+				EXPECT_EQ(itoa2(buf+34, v, radix, flags), itoa2_ref(v, radix, flags)) << "v=" << v << " radix=" << radix;
+			}
+		}
+	}
+	EXPECT_STREQ(itoa2(buf+34, 0xFFFFFFFF, 2, 0), "11111111111111111111111111111111");
+	EXPECT_STREQ(itoa2(buf+34, 0x80000000, 2, ITOA2_SIGNED), "-10000000000000000000000000000000");
+	EXPECT_STREQ(itoa2(buf+34, 0xBEEF, 16, ITOA2_UCASE), "BEEF");
+}
+
+TEST(ConvMiscTest, itoa2_64) {
+	char buf[66];
+	const uint64_t values[] = {
+		0, 1, 9, 10, 99, 100, 4294967295ULL, 4294967296ULL, 99999999ULL, 100000000ULL, 9999999999999999ULL,
+		10000000000000000ULL, 12345678901234567890ULL, 0x7FFFFFFFFFFFFFFFULL, 0x8000000000000000ULL,
+		0xFFFFFFFFFFFFFFFFULL, (uint64_t)-1234567890123LL,
+	};
+	for (int radix=2; radix<=36; radix++)
+	{
+		for (uint64_t v : values)
+		{
+			for (uint8_t flags : {0, ITOA2_UCASE, ITOA2_SIGNED, ITOA2_SIGNED|ITOA2_NOSIGN})
+			{
+				EXPECT_EQ(itoa2_64(buf+66, v, radix, flags), itoa2_ref(v, radix, flags)) << "v=" << v << " radix=" << radix;
+			}
+		}
+	}
+	EXPECT_STREQ(itoa2_64(buf+66, 0x8000000000000000ULL, 2, ITOA2_SIGNED), "-1000000000000000000000000000000000000000000000000000000000000000");
+	EXPECT_STREQ(itoa2_64(buf+66, 18446744073709551615ULL, 10, 0), "18446744073709551615");
+	EXPECT_STREQ(itoa2_64(buf+66, 100000000000000001ULL, 10, 0), "100000000000000001");
+}
+
+TEST(ConvMiscTest, itoa2_sizes) {
+	char buf[34];
+	for (int radix=2; radix<=36; radix++)
+	{
+		for (unsigned int v=0; v<256; v++)
+		{
+			for (uint8_t flags : {0, ITOA2_UCASE, ITOA2_SIGNED})
+			{
+				EXPECT_EQ(itoa2_8(buf+34, v, radix, flags), itoa2_ref((uint8_t)v, radix, flags)) << "v=" << v << " radix=" << radix;
+			}
+		}
+		for (uint32_t v : {0U, 255U, 65535U, 65536U, 99999U, 100000U, 0x7FFFFFFFU, 0x80000000U, 0xFFFFFFFFU})
+		{
+			for (uint8_t flags : {0, ITOA2_UCASE, ITOA2_SIGNED})
+			{
+				EXPECT_EQ(itoa2_32(buf+34, v, radix, flags), itoa2_ref(v, radix, flags)) << "v=" << v << " radix=" << radix;
+			}
+		}
+	}
+}
+
+// The original one digit at a time parsers, as a reference for the SWAR ones
+static int strtol_ref(const char *str, const char **end, int radix, bool sign)
+{
+	unsigned int maxv; int maxd;
+	int v = 0, n = 0, f = 0, c;
+	if (end) *end = str;
+	while (isspace((uint8_t)(c=*str))) str++;
+	if (sign && c=='+') str++; else if (sign && c=='-') n=1, str++;
+	if ((radix==0 || radix==16) && str[0]=='0' && (str[1]=='x' || str[1]=='X')) radix=16, str+=2;
+	else if (radix==0) radix = (str[0]=='0' ? 8 : 10);
+	maxv = (n ? -(unsigned int)INT_MIN : INT_MAX);
+	maxd = maxv % radix;
+	maxv = maxv / radix;
+	while (1)
+	{
+		c = *str++;
+		if      (c>='0' && c<='9') c = c - '0';
+		else if (c>='a' && c<='z') c = c - 'a' + 10;
+		else if (c>='A' && c<='Z') c = c - 'A' + 10;
+		else break;
+		if (c>=radix) break;
+		if (f==2) continue;
+		if ((unsigned)v<maxv || ((unsigned)v==maxv && c<=maxd)) f=1, v*=radix, v+=c; else f=2;
+	}
+	if (f && end) *end = str-1;
+	return (f==2 ? (n ? INT_MIN : INT_MAX) : (n ? -v : v));
+}
+
+TEST(ConvMiscTest, strtol) {
+	const char *e;
+	EXPECT_EQ(strtol_b10("123456789", &e), 123456789);      EXPECT_EQ(*e, 0);
+	EXPECT_EQ(strtol_b10(" -2147483648x", &e), INT_MIN);    EXPECT_EQ(*e, 'x');
+	EXPECT_EQ(strtol_b10("2147483647", &e), INT_MAX);       EXPECT_EQ(*e, 0);
+	EXPECT_EQ(strtol_b10("2147483648", &e), INT_MAX);       EXPECT_EQ(*e, 0);
+	EXPECT_EQ(strtol_b10("-000000000000012345,", &e), -12345); EXPECT_EQ(*e, ',');
+	EXPECT_EQ(strtol_b10("99999999999999999999 ", &e), INT_MAX); EXPECT_EQ(*e, ' ');
+	EXPECT_EQ(strtol_b10u("12345678/9", &e), 12345678);     EXPECT_EQ(*e, '/');
+	EXPECT_EQ(strtol_b10u("-1", &e), 0);                    EXPECT_EQ(*e, '-');
+	EXPECT_EQ(qstrtol("1234567890:", &e, 10), 1234567890);  EXPECT_EQ(*e, ':');
+	EXPECT_EQ(qstrtol("12345678", &e, 0), 12345678);        EXPECT_EQ(*e, 0);
+	// Short strings in exact sized heap blocks, where reading past the NUL is caught under ASan
+	for (const char *t : { "42", "-7", "1234567", "" })
+	{
+		char *h = strdup(t);
+		EXPECT_EQ(strtol_b10(h, &e), atoi(t));              EXPECT_EQ(*e, 0);
+		EXPECT_EQ(strtol_b10u(h, &e), atoi(t)<0 ? 0 : atoi(t));
+		EXPECT_EQ(qstrtol(h, &e, 10), atoi(t));             EXPECT_EQ(*e, 0);
+		free(h);
+	}
+}
+
+TEST(ConvMiscTest, strtol_fuzz) {
+	// Random digit heavy strings, placed so some of them run up to a page end where the SWAR load can't be used
+	static const char chars[] = "0123456789000099 +-/:x\xB0";
+	char *page = (char *)aligned_alloc(4096, 8192);
+	uint32_t seed = 1;
+	auto rnd = [&]() { seed = seed*1103515245 + 12345; return seed>>8; };
+	for (int i=0; i<200000; i++)
+	{
+		int len = rnd()%24;
+		char *s = page + (i&1 ? 4096-1-len : rnd()%(8192-32));
+		for (int j=0; j<len; j++) s[j] = chars[rnd()%(sizeof(chars)-1)];
+		s[len] = 0;
+		const char *e, *re;
+		int v = strtol_b10(s, &e), rv = strtol_ref(s, &re, 10, true);
+		ASSERT_EQ(v, rv) << s;
+		ASSERT_EQ(e, re) << s;
+		v = strtol_b10u(s, &e), rv = strtol_ref(s, &re, 10, false);
+		ASSERT_EQ(v, rv) << s;
+		ASSERT_EQ(e, re) << s;
+		v = qstrtol(s, &e, 10), rv = strtol_ref(s, &re, 10, true);
+		ASSERT_EQ(v, rv) << s;
+		ASSERT_EQ(e, re) << s;
+	}
+	free(page);
+}
+
+TEST(ConvMiscTest, strtofix) {
+	const char *e, *s;
+	EXPECT_EQ(strtofix("12.34", &e, 2), 1234);              EXPECT_EQ(*e, 0);
+	EXPECT_EQ(strtofix(" -12.3x", &e, 2), -1230);           EXPECT_EQ(*e, 'x');
+	EXPECT_EQ(strtofix("+12", &e, 3), 12000);               EXPECT_EQ(*e, 0);
+	EXPECT_EQ(strtofix("12.", &e, 1), 120);                 EXPECT_EQ(*e, 0);
+	EXPECT_EQ(strtofix(".5", &e, 1), 5);                    EXPECT_EQ(*e, 0);
+	EXPECT_EQ(strtofix("-.05", &e, 2), -5);                 EXPECT_EQ(*e, 0);
+	EXPECT_EQ(strtofix("1.2.3", &e, 2), 120);               EXPECT_EQ(*e, '.');
+	EXPECT_EQ(strtofix("7", &e, 0), 7);                     EXPECT_EQ(*e, 0);
+	// Extra digits round
+	EXPECT_EQ(strtofix("1.2345", &e, 2), 123);              EXPECT_EQ(*e, 0);
+	EXPECT_EQ(strtofix("1.235", &e, 2), 124);               EXPECT_EQ(*e, 0);
+	EXPECT_EQ(strtofix("-1.995", &e, 2), -200);             EXPECT_EQ(*e, 0);
+	EXPECT_EQ(strtofix("0.5", &e, 0), 1);                   EXPECT_EQ(*e, 0);
+	// No number
+	s = " .";  EXPECT_EQ(strtofix(s, &e, 2), 0);           EXPECT_EQ(e, s);
+	s = "-x";  EXPECT_EQ(strtofix(s, &e, 2), 0);           EXPECT_EQ(e, s);
+	s = "";    EXPECT_EQ(strtofix(s, NULL, 2), 0);
+	// Saturation, consuming all the digits
+	EXPECT_EQ(strtofix("21474836.47", &e, 2), INT32_MAX);   EXPECT_EQ(*e, 0);
+	EXPECT_EQ(strtofix("21474836.48 ", &e, 2), INT32_MAX);  EXPECT_EQ(*e, ' ');
+	EXPECT_EQ(strtofix("-21474836.48", &e, 2), INT32_MIN);  EXPECT_EQ(*e, 0);
+	EXPECT_EQ(strtofix("-21474836.49", &e, 2), INT32_MIN);  EXPECT_EQ(*e, 0);
+	EXPECT_EQ(strtofix("21474836.4699", &e, 2), INT32_MAX); EXPECT_EQ(*e, 0);
+	EXPECT_EQ(strtofix("2147483.647", &e, 2), 214748365);   EXPECT_EQ(*e, 0);
+	EXPECT_EQ(strtofix("99999999999.9;", &e, 1), INT32_MAX); EXPECT_EQ(*e, ';');
+	EXPECT_EQ(strtofix("3", &e, 10), INT32_MAX);            EXPECT_EQ(*e, 0);
+	EXPECT_EQ(strtofix16("327.67", &e, 2), 32767);          EXPECT_EQ(*e, 0);
+	EXPECT_EQ(strtofix16("327.675", &e, 2), 32767);         EXPECT_EQ(*e, 0);
+	EXPECT_EQ(strtofix16("-327.68", &e, 2), -32768);        EXPECT_EQ(*e, 0);
+	EXPECT_EQ(strtofix16("-1000", &e, 2), -32768);          EXPECT_EQ(*e, 0);
+	EXPECT_EQ(strtofix16("-12.5", &e, 1), -125);            EXPECT_EQ(*e, 0);
+	// Round trip with %$
+	char buf[16];
+	for (int v=-100000; v<=100000; v+=7)
+	{
+		qsprintf(buf, sizeof(buf), "%.3$", v);
+		ASSERT_EQ(strtofix(buf, &e, 3), v) << buf;
+		ASSERT_EQ(*e, 0);
+	}
+}
+
+TEST(ConvMiscTest, strtofix_q) {
+	const char *e, *s;
+	EXPECT_EQ(strtofix_q("1.5", &e, 16), 0x18000);          EXPECT_EQ(*e, 0);
+	EXPECT_EQ(strtofix_q("-1.5", &e, 16), -0x18000);        EXPECT_EQ(*e, 0);
+	EXPECT_EQ(strtofix_q("0.1", &e, 16), 6554);             EXPECT_EQ(*e, 0);  // 6553.6
+	EXPECT_EQ(strtofix_q("3.14159265358979 ", &e, 24), 52707179); EXPECT_EQ(*e, ' ');
+	EXPECT_EQ(strtofix_q("3.14159265358979", &e, 28), 843314856); EXPECT_EQ(*e, 0);  // Truncated at 28 bits
+	EXPECT_EQ(strtofix_q("12.", &e, 8), 12<<8);             EXPECT_EQ(*e, 0);
+	EXPECT_EQ(strtofix_q(".25", &e, 2), 1);                 EXPECT_EQ(*e, 0);
+	EXPECT_EQ(strtofix_q("100", &e, 0), 100);               EXPECT_EQ(*e, 0);
+	EXPECT_EQ(strtofix_q("0.99999999", &e, 8), 256);        EXPECT_EQ(*e, 0);
+	s = ".";  EXPECT_EQ(strtofix_q(s, &e, 16), 0);          EXPECT_EQ(e, s);
+	s = "+";  EXPECT_EQ(strtofix_q(s, &e, 16), 0);          EXPECT_EQ(e, s);
+	// Saturation
+	EXPECT_EQ(strtofix_q("32767.99999", &e, 16), INT32_MAX); EXPECT_EQ(*e, 0);
+	EXPECT_EQ(strtofix_q("32768", &e, 16), INT32_MAX);      EXPECT_EQ(*e, 0);
+	EXPECT_EQ(strtofix_q("-32768", &e, 16), INT32_MIN);     EXPECT_EQ(*e, 0);
+	EXPECT_EQ(strtofix_q("-32768.5", &e, 16), INT32_MIN);   EXPECT_EQ(*e, 0);
+	EXPECT_EQ(strtofix_q("123456789012.5x", &e, 4), INT32_MAX); EXPECT_EQ(*e, 'x');
+	// Round trip with %k, which prints at most 4 digits (so to within 65536/20000)
+	char buf[24];
+	for (int v=-0x40000; v<=0x40000; v+=3)
+	{
+		qsprintf(buf, sizeof(buf), "%.4k", v);
+		ASSERT_NEAR(strtofix_q(buf, &e, 16), v, 4) << buf;
+		ASSERT_EQ(*e, 0);
+	}
+}
+
+TEST(ConvMiscTest, parse_ints) {
+	int v[4];
+	const char *e, *s;
+	s = "1 -2,3\t, 0x10\n";
+	EXPECT_EQ(parse_ints(s, 0, v, 4, &e), 4);
+	EXPECT_EQ(e, s+13);
+	EXPECT_EQ(v[0], 1); EXPECT_EQ(v[1], -2); EXPECT_EQ(v[2], 3); EXPECT_EQ(v[3], 16);
+	s = "";
+	EXPECT_EQ(parse_ints(s, 10, v, 4, &e), 0);
+	EXPECT_EQ(e, s);
+	// Errors leave end at the bad field
+	s = "5 6x 7";
+	EXPECT_EQ(parse_ints(s, 10, v, 4, &e), 1);
+	EXPECT_EQ(e, s+2);
+	s = "5,, -";
+	EXPECT_EQ(parse_ints(s, 10, v, 4, &e), 1);
+	EXPECT_EQ(e, s+4);
+	s = "1 2 3 4 5";
+	EXPECT_EQ(parse_ints(s, 10, v, 4, &e), 4);
+	EXPECT_EQ(e, s+8);
+	s = "ff FF 10";
+	EXPECT_EQ(parse_ints(s, 16, v, 4, NULL), 3);
+	EXPECT_EQ(v[0], 255); EXPECT_EQ(v[1], 255); EXPECT_EQ(v[2], 16);
+}
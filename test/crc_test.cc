@@ -0,0 +1,57 @@
+#include "main.h"
+
+// Bit at a time references
+static uint32_t crc_ref(const uint8_t *p, int n, int width, uint32_t poly, uint32_t crc, bool reflected)
+{
+	uint32_t top = 1u<<(width-1), mask = (width==32 ? ~0u : (1u<<width)-1);
+	for (int i=0; i<n; i++)
+	{
+		if (reflected) crc ^= p[i];
+		else crc ^= (uint32_t)p[i]<<(width-8);
+		for (int b=0; b<8; b++)
+		{
+			if (reflected) crc = (crc&1 ? crc>>1 ^ poly : crc>>1);
+			else crc = (crc&top ? crc<<1 ^ poly : crc<<1) & mask;
+		}
+	}
+	return crc;
+}
+
+TEST(CrcTest, check) {
+	// The standard check values, of "123456789"
+	const char *s = "123456789";
+	EXPECT_EQ(crc16_ccitt_update(CRC16_CCITT_INIT, s, 9), 0x29B1);
+	EXPECT_EQ(crc16_modbus_update(CRC16_MODBUS_INIT, s, 9), 0x4B37);
+	EXPECT_EQ(crc32_update(CRC32_INIT, s, 9), 0xCBF43926);
+	EXPECT_EQ(crc16_ccitt_nibble(CRC16_CCITT_INIT, s, 9), 0x29B1);
+	EXPECT_EQ(crc16_modbus_nibble(CRC16_MODBUS_INIT, s, 9), 0x4B37);
+	EXPECT_EQ(crc32_nibble(CRC32_INIT, s, 9), 0xCBF43926);
+	EXPECT_EQ(crc32_update(CRC32_INIT, s, 0), 0);
+	EXPECT_EQ(crc16_ccitt_update(0x1234, s, -1), 0x1234);
+}
+
+TEST(CrcTest, lengths) {
+	// Every length and alignment around the slices, against the references, and fed in two pieces
+	uint8_t data[80];
+	for (int i=0; i<(int)sizeof(data); i++) data[i] = i*131+7;
+	for (int off=0; off<8; off++)
+	{
+		for (int n=0; n+off<=(int)sizeof(data); n++)
+		{
+			const uint8_t *p = data+off;
+			uint16_t ccitt = crc_ref(p, n, 16, 0x1021, 0xFFFF, false);
+			uint16_t modbus = crc_ref(p, n, 16, 0xA001, 0xFFFF, true);
+			uint32_t crc32 = ~crc_ref(p, n, 32, 0xEDB88320, ~0u, true);
+			ASSERT_EQ(crc16_ccitt_update(CRC16_CCITT_INIT, p, n), ccitt) << off << " " << n;
+			ASSERT_EQ(crc16_modbus_update(CRC16_MODBUS_INIT, p, n), modbus) << off << " " << n;
+			ASSERT_EQ(crc32_update(CRC32_INIT, p, n), crc32) << off << " " << n;
+			ASSERT_EQ(crc16_ccitt_nibble(CRC16_CCITT_INIT, p, n), ccitt);
+			ASSERT_EQ(crc16_modbus_nibble(CRC16_MODBUS_INIT, p, n), modbus);
+			ASSERT_EQ(crc32_nibble(CRC32_INIT, p, n), crc32);
+			int k = n/3;
+			ASSERT_EQ(crc16_ccitt_update(crc16_ccitt_update(CRC16_CCITT_INIT, p, k), p+k, n-k), ccitt);
+			ASSERT_EQ(crc16_modbus_update(crc16_modbus_nibble(CRC16_MODBUS_INIT, p, k), p+k, n-k), modbus);
+			ASSERT_EQ(crc32_nibble(crc32_update(CRC32_INIT, p, k), p+k, n-k), crc32);
+		}
+	}
+}
@@ -0,0 +1,290 @@
+// Differential fuzzer for conv.c.  Each input is turned into a format spec and argument (or a number or
+// string to parse), which is run through all of the formatters/parsers and checked against glibc where the
+// semantics overlap, and against the other formatters and reference implementations otherwise.
+// Builds as a libFuzzer target with -D LIBFUZZER, or standalone (see fuzz.sh), where it runs the given
+// input files or random inputs.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include <ctype.h>
+#include <string>
+#include <vector>
+
+extern "C"
+{
+#include "lillib.h"
+}
+
+#define CHECK(cond, ...) do { if (!(cond)) { fprintf(stderr, __VA_ARGS__); fprintf(stderr, "\n"); abort(); } } while (0)
+
+// Consumes the fuzz input a choice at a time, giving 0s when it runs out
+struct Input
+{
+	const uint8_t *p, *end;
+	uint8_t byte() { return (p<end ? *p++ : 0); }
+	uint64_t bytes(int n) { uint64_t v = 0; while (n--) v = (v<<8)|byte(); return v; }
+	int pick(int n) { return byte()%n; }
+};
+
+// Output of all of the formatters for one call, which must agree
+static std::vector<char> g_putc;
+static void fuzz_putc(char c) { g_putc.push_back(c); }
+static void fuzz_write(const char *s, int n, char c) { while (n-- > 0) g_putc.push_back(s ? *s++ : c); }
+
+static std::string fmt_all(const char *fmt, ...)
+{
+	char buf[256];
+	va_list args, a2, a3, a4;
+	va_start(args, fmt);
+	va_copy(a2, args);
+	va_copy(a3, args);
+	va_copy(a4, args);
+	int n = strf_sprint(buf, sizeof(buf), fmt, args);
+	std::string s(buf);
+	CHECK(n==(int)s.size() || (n>=(int)sizeof(buf) && s.size()==sizeof(buf)-1), "%s: sprint length %i for \"%s\"", fmt, n, buf);
+	g_putc.clear();
+	strf_print(fuzz_putc, fmt, a2);
+	CHECK(std::string(g_putc.begin(), g_putc.end()).substr(0, sizeof(buf)-1)==s, "%s: print/sprint differ", fmt);
+	g_putc.clear();
+	strf_print_bulk(fuzz_write, fmt, a3);
+	CHECK(std::string(g_putc.begin(), g_putc.end()).substr(0, sizeof(buf)-1)==s, "%s: print_bulk/sprint differ", fmt);
+	CHECK(strf_sprint(NULL, 0, fmt, a4)==n, "%s: measure differs", fmt);
+	va_end(a4);
+	va_end(a3);
+	va_end(a2);
+	va_end(args);
+	return s;
+}
+
+static std::string fmt_glibc(const char *fmt, ...)
+{
+	char buf[512];
+	va_list args;
+	va_start(args, fmt);
+	vsnprintf(buf, sizeof(buf), fmt, args);
+	va_end(args);
+	return buf;
+}
+
+// A printf spec, kept to what glibc shares (width, - + space and 0 flags, precision for strings and
+// floats) if compat is set, otherwise anything strf_conv parses.  Flags are in the order strf_conv
+// wants them.  zero is set if it has the 0 flag.
+static std::string fuzz_spec(Input &in, bool compat, bool prec, bool *zero)
+{
+	static const char aligns[] = "-<>=^";
+	std::string s = "%";
+	int f = in.pick(4);
+	if (compat && f==1) s += '-';
+	if (!compat && f==1)
+	{
+		char fill = 0x20 + in.pick(0x5F);
+		if (fill!='%') s += fill;
+		s += aligns[in.pick(5)];
+	}
+	int sign = in.pick(3);
+	if (sign) s += (sign==1 ? '+' : ' ');
+	*zero = (f==2);
+	if (*zero) s += '0';
+	if (in.pick(2)) s += std::to_string(in.pick(40));
+	if (prec && in.pick(2)) s += '.' + std::to_string(in.pick(compat ? 17 : 40));
+	return s;
+}
+
+static void fuzz_ints(Input &in)
+{
+	static const char types[] = "diuxXo";
+	static const char *sizes[] = { "", "hh", "h", "l", "ll" };
+	bool compat = in.pick(2), zero;
+	std::string spec = fuzz_spec(in, compat, false, &zero);
+	int size = in.pick(5);
+	char type = types[in.pick(6)];
+	std::string fmt = "[" + spec + sizes[size] + type + "]";
+	uint64_t v = in.bytes(8);
+	std::string r, g;
+	switch (size)
+	{
+		case 0: r = fmt_all(fmt.c_str(), (int)v);        g = (compat ? fmt_glibc(fmt.c_str(), (int)v) : r); break;
+		case 1: r = fmt_all(fmt.c_str(), (int)v);        g = (compat ? fmt_glibc(fmt.c_str(), (int)v) : r); break;
+		case 2: r = fmt_all(fmt.c_str(), (int)v);        g = (compat ? fmt_glibc(fmt.c_str(), (int)v) : r); break;
+		case 3: r = fmt_all(fmt.c_str(), (long)v);       g = (compat ? fmt_glibc(fmt.c_str(), (long)v) : r); break;
+		case 4: r = fmt_all(fmt.c_str(), (long long)v);  g = (compat ? fmt_glibc(fmt.c_str(), (long long)v) : r); break;
+	}
+	// strf keeps +/space on unsigned types, where glibc drops them
+	if (compat && (type=='d' || type=='i' || spec.find_first_of("+ ")==std::string::npos))
+		CHECK(r==g, "%s: \"%s\" vs glibc \"%s\"", fmt.c_str(), r.c_str(), g.c_str());
+}
+
+static void fuzz_strings(Input &in)
+{
+	bool compat = in.pick(2), zero;
+	std::string spec = fuzz_spec(in, compat, true, &zero);
+	if (compat && zero) return; // 0 flag is undefined for %s
+	char str[24];
+	int n = in.pick(sizeof(str));
+	for (int i=0; i<n; i++) str[i] = 1 + in.pick(255);
+	str[n] = 0;
+	std::string fmt = "[" + spec + "s|" + spec + "S|%c]";
+	char c = 1 + in.pick(255);
+	std::string r = fmt_all(fmt.c_str(), str, str, c);
+	if (!compat) return;
+	std::string g = fmt_glibc(("[" + spec + "s|" + spec + "s|%c]").c_str(), str, str, c);
+	CHECK(r==g, "%s: \"%s\" vs glibc \"%s\"", fmt.c_str(), r.c_str(), g.c_str());
+}
+
+// Whether x to prec places (e or f style) is at or near halfway (within 1/100 of a unit), where strf_ftoa's
+// rounding may differ from glibc's.  Ties go to even as in glibc when the power of ten it scales by is exact
+// (10^0 to 10^27), but beyond that the power is a few ulps off and it can't tell a tie from a near tie.
+static bool float_tie(double x, char type, int prec)
+{
+	char buf[1200];
+	const char *d;
+	if (type=='e') snprintf(buf, sizeof(buf), "%.*e", prec+40, fabs(x)), d = strchr(buf, '.')+1+prec;
+	else           snprintf(buf, sizeof(buf), "%.*f", prec+1100, fabs(x)), d = strchr(buf, '.')+1+prec;
+	return !strncmp(d, "50", 2) || !strncmp(d, "49", 2);
+}
+
+static void fuzz_floats(Input &in)
+{
+	static const char types[] = "feEgG";
+	bool compat = in.pick(2), zero;
+	std::string spec = fuzz_spec(in, compat, true, &zero);
+	char type = types[in.pick(5)];
+	std::string fmt = "[" + spec + type + "]";
+	uint64_t u = in.bytes(8);
+	double x;
+	memcpy(&x, &u, sizeof(x));
+	if (in.pick(2)) x = (double)(int64_t)u / (double)(1ULL<<in.pick(64));
+	std::string r = fmt_all(fmt.c_str(), x);
+	if (!compat || !isfinite(x)) return;
+	std::string g = fmt_glibc(fmt.c_str(), x);
+	// Compare where strf_ftoa's digits are exact: at most 16 significant digits, away from ties and
+	// within its buffer, and with f style only for moderate numbers
+	size_t dot = spec.find('.');
+	int prec = (dot==std::string::npos ? 6 : atoi(spec.c_str()+dot+1));
+	char t = type|0x20;
+	if (t=='g')
+	{
+		if (!prec) prec = 1;
+		if (prec>16 || float_tie(x, 'e', prec-1)) return;
+		char buf[64];
+		snprintf(buf, sizeof(buf), "%.*e", prec-1, x);
+		int k = atoi(strchr(buf, 'e')+1);
+		if (k>=-4 && k<prec && float_tie(x, 'f', prec-1-k)) return;
+	}
+	if (t=='e' && (prec>15 || float_tie(x, 'e', prec))) return;
+	if (t=='f' && (fabs(x)>=1e15 || (x!=0 && fabs(x)<1e-5) || float_tie(x, 'f', prec) || (fabs(x)>=1 ? log10(fabs(x))+1 : 0)+prec>16)) return;
+	CHECK(r==g, "%s %.17g: \"%s\" vs glibc \"%s\"", fmt.c_str(), x, r.c_str(), g.c_str());
+}
+
+// Reference itoa: digits of the low bits of uv, which is signed if ITOA2_SIGNED and negative for its width
+static std::string itoa_ref(uint64_t uv, int bits, uint64_t radix, uint8_t flags)
+{
+	static const char lc[] = "0123456789abcdefghijklmnopqrstuvwxyz", uc[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+	uint64_t m = (bits==64 ? ~0ULL : (1ULL<<bits)-1);
+	bool neg = (flags&ITOA2_SIGNED) && ((uv>>(bits-1))&1);
+	std::string s;
+	uv &= m;
+	if (neg) uv = (0-uv)&m;
+	// (One division per digit: gcc 12's -fsanitize=undefined miscompiles uv%radix next to uv/radix here)
+	const char *digits = ((flags&ITOA2_UCASE) ? uc : lc);
+	do { uint64_t q = uv/radix; s.insert(s.begin(), digits[uv-q*radix]); uv = q; } while (uv);
+	if (neg && !(flags&ITOA2_NOSIGN)) s.insert(s.begin(), '-');
+	return s;
+}
+
+static void fuzz_itoa(Input &in)
+{
+	char buf[80];
+	int radix = 2 + in.pick(35);
+	uint8_t flags = in.pick(8);
+	uint64_t v = in.bytes(8);
+	std::string r;
+	r = itoa2_8(buf+sizeof(buf), (uint8_t)v, radix, flags);
+	CHECK(r==itoa_ref(v, 8, radix, flags), "itoa2_8 radix %i flags %i: \"%s\" vs \"%s\"", radix, flags, r.c_str(), itoa_ref(v, 8, radix, flags).c_str());
+	r = itoa2(buf+sizeof(buf), (unsigned int)v, radix, flags);
+	CHECK(r==itoa_ref(v, 8*sizeof(int), radix, flags), "itoa2 radix %i flags %i: \"%s\" vs \"%s\"", radix, flags, r.c_str(), itoa_ref(v, 8*sizeof(int), radix, flags).c_str());
+	r = itoa2_32(buf+sizeof(buf), (uint32_t)v, radix, flags);
+	CHECK(r==itoa_ref(v, 32, radix, flags), "itoa2_32 radix %i flags %i: \"%s\" vs \"%s\"", radix, flags, r.c_str(), itoa_ref(v, 32, radix, flags).c_str());
+	r = itoa2_64(buf+sizeof(buf), v, radix, flags);
+	CHECK(r==itoa_ref(v, 64, radix, flags), "itoa2_64 radix %i flags %i: \"%s\" vs \"%s\"", radix, flags, r.c_str(), itoa_ref(v, 64, radix, flags).c_str());
+	if (radix==10 && !(flags&ITOA2_SIGNED))
+		CHECK(r==std::to_string((unsigned long long)v), "itoa2_64 vs glibc %llu", (unsigned long long)v);
+}
+
+static void fuzz_strtol(Input &in)
+{
+	static const char chars[] = "0123456789abcdefxXzAF +-\t\n";
+	char str[40];
+	int n = in.pick(sizeof(str));
+	for (int i=0; i<n; i++) str[i] = chars[in.pick(sizeof(chars)-1)];
+	str[n] = 0;
+	int radix = in.pick(37);
+	if (radix==1) radix = 10;
+	// qstrtol is glibc's strtol clamped to int, except that "0x" with no hex digit after it isn't a
+	// prefix in glibc (it parses the 0)
+	const char *e, *s = str;
+	char *ge;
+	int v = qstrtol(str, &e, radix);
+	long g = strtol(str, &ge, radix);
+	g = (g>INT_MAX ? INT_MAX : g<INT_MIN ? INT_MIN : g);
+	while (isspace((uint8_t)*s)) s++;
+	if (*s=='+' || *s=='-') s++;
+	bool hexquirk = (radix==0 || radix==16) && s[0]=='0' && (s[1]=='x' || s[1]=='X') && !isxdigit((uint8_t)s[2]);
+	if (!hexquirk) CHECK(v==g && e==ge, "qstrtol(\"%s\", %i) %i/%i vs glibc %li/%i", str, radix, v, (int)(e-str), g, (int)(ge-str));
+	// The base 10 versions
+	v = strtol_b10(str, &e);
+	g = strtol(str, &ge, 10);
+	g = (g>INT_MAX ? INT_MAX : g<INT_MIN ? INT_MIN : g);
+	CHECK(v==g && e==ge, "strtol_b10(\"%s\") %i/%i vs glibc %li/%i", str, v, (int)(e-str), g, (int)(ge-str));
+	s = str;
+	while (isspace((uint8_t)*s)) s++;
+	v = strtol_b10u(str, &e);
+	if (*s>='0' && *s<='9') CHECK(v==g && e==ge, "strtol_b10u(\"%s\") %i/%i vs glibc %li/%i", str, v, (int)(e-str), g, (int)(ge-str));
+	else                    CHECK(v==0 && e==str, "strtol_b10u(\"%s\") %i/%i", str, v, (int)(e-str));
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	Input in = { data, data+size };
+	switch (in.pick(5))
+	{
+		case 0: fuzz_ints(in); break;
+		case 1: fuzz_strings(in); break;
+		case 2: fuzz_floats(in); break;
+		case 3: fuzz_itoa(in); break;
+		case 4: fuzz_strtol(in); break;
+	}
+	return 0;
+}
+
+#ifndef LIBFUZZER
+int main(int argc, char *argv[])
+{
+	if (argc>1 && strcmp(argv[1], "-n"))
+	{
+		// Replay inputs (e.g. crashes found by libFuzzer)
+		for (int i=1; i<argc; i++)
+		{
+			std::vector<uint8_t> data;
+			FILE *f = fopen(argv[i], "rb");
+			if (!f) { perror(argv[i]); return 1; }
+			for (int c; (c=fgetc(f))!=EOF; ) data.push_back(c);
+			fclose(f);
+			LLVMFuzzerTestOneInput(data.data(), data.size());
+		}
+		return 0;
+	}
+	long n = (argc>2 ? atol(argv[2]) : 1000000);
+	uint64_t seed = 0x9E3779B97F4A7C15ULL;
+	uint8_t data[64];
+	for (long i=0; i<n; i++)
+	{
+		for (size_t j=0; j<sizeof(data); j++) seed = seed*6364136223846793005ULL + 1442695040888963407ULL, data[j] = seed>>56;
+		LLVMFuzzerTestOneInput(data, sizeof(data));
+	}
+	printf("%li inputs OK\n", n);
+	return 0;
+}
+#endif
@@ -0,0 +1,20 @@
+#!/bin/bash
+# Builds the conv.c fuzzer: a libFuzzer target if clang is around, otherwise a standalone random driver.
+#   fuzz.sh [N]               Run N random inputs with the standalone driver (default 1000000)
+#   fuzz.sh --libfuzzer ARGS  Build with clang -fsanitize=fuzzer and run it with ARGS (e.g. a corpus dir)
+
+cd "$(dirname "$(readlink -f "$0")")"
+mkdir -p __builddir__
+SRCS="../../conv.c ../../str.c"
+FLAGS="-O1 -g -Wall -D TESTING -I ../../ -I .. -fsanitize=address,undefined"
+
+if [ "$1" == "--libfuzzer" ]; then
+	shift
+	for f in $SRCS; do clang $FLAGS -fsanitize=fuzzer -c "$f" -o "__builddir__/$(basename "$f").o" || exit; done
+	clang++ $FLAGS -fsanitize=fuzzer -D LIBFUZZER conv_fuzz.cc __builddir__/*.c.o -o __builddir__/conv_fuzz || exit
+	__builddir__/conv_fuzz "$@"
+else
+	for f in $SRCS; do gcc $FLAGS -c "$f" -o "__builddir__/$(basename "$f").o" || exit; done
+	g++ $FLAGS conv_fuzz.cc __builddir__/*.c.o -o __builddir__/conv_fuzz || exit
+	__builddir__/conv_fuzz -n "${1:-1000000}"
+fi
@@ -0,0 +1,178 @@
+#include "main.h"
+#include <unistd.h>
+
+// Unpacks the 7 bit wire bytes of a LOG() record
+static std::vector<uint8_t> log_payload(const std::vector<char> &wire)
+{
+	std::vector<uint8_t> r;
+	unsigned acc = 0, bits = 0;
+	EXPECT_GE(wire.size(), 2u);
+	EXPECT_EQ(wire[0], LOG_MARKER);
+	EXPECT_EQ((size_t)wire[1], wire.size()-2);
+	for (size_t i=2; i<wire.size(); i++)
+	{
+		EXPECT_EQ(wire[i]&0x80, 0);
+		acc |= (unsigned)wire[i]<<bits, bits += 7;
+		if (bits>=8) r.push_back(acc&0xFF), acc >>= 8, bits -= 8;
+	}
+	return r;
+}
+
+template <typename T>
+static void log_expect(std::vector<uint8_t> &p, size_t &i, T v)
+{
+	ASSERT_LE(i+sizeof(T), p.size());
+	T x;
+	memcpy(&x, &p[i], sizeof(T));
+	EXPECT_EQ(x, v);
+	i += sizeof(T);
+}
+
+TEST(LogTest, record) {
+	std::vector<char> out;
+	const char *fmt1 = "%-5i|%*.*hhx|%+hd|%ld";
+	const char *fmt2 = "%lld|%c%%%s|%.2f";
+	const char *fmt3 = "%S|%k|%08.*$|%Q";
+	g_com_putc_data = &out;
+	log_P(fmt1, -2, 7, 3, 0x1FF, -3, 123456789L);
+	std::vector<uint8_t> p = log_payload(out);
+	size_t i = 0;
+	log_expect(p, i, fmt1);
+	log_expect(p, i, -2);
+	log_expect(p, i, 7);
+	log_expect(p, i, 3);
+	log_expect(p, i, (uint8_t)0xFF);
+	log_expect(p, i, (int16_t)-3);
+	log_expect(p, i, 123456789L);
+	EXPECT_EQ(i, p.size());
+
+	out.clear();
+	log_P(fmt2, -1LL, 'z', "ab", 1.5);
+	p = log_payload(out);
+	i = 0;
+	log_expect(p, i, fmt2);
+	log_expect(p, i, -1LL);
+	log_expect(p, i, 'z');
+	log_expect(p, i, 'a');
+	log_expect(p, i, 'b');
+	log_expect(p, i, '\0');
+	log_expect(p, i, 1.5);
+	EXPECT_EQ(i, p.size());
+
+	out.clear();
+	log_P(fmt3, "flash", 0x18000, 3, 1234);
+	p = log_payload(out);
+	i = 0;
+	log_expect(p, i, fmt3);
+	log_expect(p, i, (const char *)"flash");
+	log_expect(p, i, 0x18000);
+	log_expect(p, i, 3);
+	log_expect(p, i, 1234);
+	EXPECT_EQ(i, p.size());
+	g_com_putc_data = nullptr;
+}
+
+TEST(LogTest, overflow) {
+	// Arguments that don't fit are dropped, strings are cut to fit
+	std::vector<char> out;
+	g_com_putc_data = &out;
+	log_P("%s %i", "0123456789012345678901234567890123456789", 5);
+	g_com_putc_data = nullptr;
+	std::vector<uint8_t> p = log_payload(out);
+	EXPECT_EQ(p.size(), (size_t)LILLIB_CFG_LOG_RECORD_SIZE);
+	EXPECT_EQ(p.back(), 0);
+	EXPECT_EQ(memcmp(&p[sizeof(char *)], "0123456789", 10), 0);
+}
+
+// Logs fmt and appends what the device would have printed for it (and a newline between records)
+template <typename... A>
+static void log_both(std::string &want, const char *fmt, A... args)
+{
+	char buf[200];
+	qsprintf(buf, sizeof(buf), fmt, args...);
+	want += buf;
+	want += '\n';
+	log_P(fmt, args...);
+	com_putc('\n');
+}
+
+TEST(LogTest, tool) {
+	// tool/log_decode.py turns records back into what qsprintf makes of the same arguments, using this ELF
+	// for the format strings (so test.sh links with -no-pie)
+	std::vector<char> out;
+	std::string want, text;
+	char exe[512];
+	ssize_t n = readlink("/proc/self/exe", exe, sizeof(exe)-1);
+	ASSERT_GT(n, 0);
+	exe[n] = 0;
+	g_com_putc_data = &out;
+	log_both(want, "%-5i|%*.*hhx|%+hd|%ld", -2, 7, 3, 0x1FF, -3, 123456789L);
+	log_both(want, "%lld|%llu|%llx", -1234567890123LL, 18446744073709551615ULL, 0xFEDCBA98ULL);
+	log_both(want, "%ll$|%.4ll$|%ll$", -123456789012LL, 5LL, 0LL);
+	log_both(want, "%$|%.0$|%08.3$|%c%%%s", -5, 42, 1234, 'z', "ab");
+	log_both(want, "%S|%k|%.2K|%#x", (const char *)"flash", 0x18000, 0xFFFF8000u, 7);
+	log_both(want, "%.2f|%e|%g", 1.005, -0.000123, 1e20);
+	log_both(want, "%^9s|%*X|%o|%b", "mid", -6, 0xBEEFu, 8u, 5u);
+	g_com_putc_data = nullptr;
+	if (!tool_run(std::string("log_decode.py ") + exe, std::vector<uint8_t>(out.begin(), out.end()), &text))
+		GTEST_SKIP() << "no python3";
+	EXPECT_EQ(text, want);
+}
+
+// The wire bytes of a record with payload, packed as log_P does it
+static void log_wire(std::vector<uint8_t> &out, const std::vector<uint8_t> &payload)
+{
+	unsigned acc = 0, bits = 0;
+	size_t at = out.size();
+	out.insert(out.end(), { LOG_MARKER, 0 });
+	for (uint8_t b : payload)
+	{
+		acc |= (unsigned)b<<bits, bits += 8;
+		while (bits>=7) out.push_back(acc&0x7F), acc >>= 7, bits -= 7;
+	}
+	if (bits) out.push_back(acc&0x7F);
+	out[at+1] = out.size()-at-2;
+}
+
+TEST(LogTest, tool_avr) {
+	// The AVR's type sizes, and its %ll, which prints "<ll?>" (through the fixed point '.' for %ll$) as
+	// conv.c does without LILLIB_CFG_CONV_LONGLONG.  The formats go in a minimal 32 bit AVR ELF, loaded
+	// at 0x100, as the decoder only needs the machine and the loaded sections.
+	const char *fmts[] = { "[%ll$]", "[%.4ll$]", "[%.8ll$]", "[%8ll$]", "[%+lld|%hd|%ld]", "[%+.1f]" };
+	std::string strs, text;
+	std::vector<uint8_t> elf(52), capture;
+	for (const char *f : fmts) strs += f, strs += '\0';
+	elf[0] = 0x7F, elf[1] = 'E', elf[2] = 'L', elf[3] = 'F', elf[4] = 1, elf[5] = 1, elf[6] = 1;
+	elf[0x12] = 83;                                          // EM_AVR
+	elf[0x20] = 52 + strs.size();                            // e_shoff
+	elf[0x2E] = 40, elf[0x30] = 1;                           // e_shentsize, e_shnum
+	elf.insert(elf.end(), strs.begin(), strs.end());
+	uint32_t sh[10] = { 0, 1, 2, 0x100, 52, (uint32_t)strs.size() }; // PROGBITS, SHF_ALLOC, addr, offset, size
+	elf.insert(elf.end(), (uint8_t *)sh, (uint8_t *)(sh+10));
+	uint16_t addr = 0x100;
+	for (const char *f : fmts)
+	{
+		std::vector<uint8_t> payload = { (uint8_t)addr, (uint8_t)(addr>>8) };
+		int64_t v = 5;
+		float x = 1.5f;
+		if (f[3]=='.') payload.insert(payload.end(), (uint8_t *)&x, (uint8_t *)(&x+1));
+		else           payload.insert(payload.end(), (uint8_t *)&v, (uint8_t *)(&v+1));
+		if (f[2]=='+') payload.insert(payload.end(), { 0xFD, 0xFF, 0x40, 0xE2, 0x01, 0x00 }); // -3, 123456
+		log_wire(capture, payload);
+		capture.push_back('\n');
+		addr += strlen(f)+1;
+	}
+	char path[] = "/tmp/lillib_avr_elf_XXXXXX";
+	int fd = mkstemp(path);
+	ASSERT_GE(fd, 0);
+	ASSERT_EQ(write(fd, elf.data(), elf.size()), (ssize_t)elf.size());
+	close(fd);
+	// And its floats, left off by default but for builds that turn them on
+	std::string floats;
+	bool ran = tool_run(std::string("log_decode.py ") + path, capture, &text) &&
+		tool_run(std::string("log_decode.py --avr-float ") + path, capture, &floats);
+	unlink(path);
+	if (!ran) GTEST_SKIP() << "no python3";
+	EXPECT_EQ(text, "[<ll.?>]\n[<.ll?>]\n[.000<ll?>]\n[  <ll.?>]\n[+<ll?>|-3|123456]\n[+<float?>]\n");
+	EXPECT_EQ(floats.substr(floats.rfind('[')), "[+1.5]\n");
+}
@@ -0,0 +1,78 @@
+#include "main.h"
+
+// Log-like lines, random bytes and runs
+static std::vector<uint8_t> lzss_data(int kind, int n)
+{
+	std::vector<uint8_t> v;
+	char line[80];
+	for (int i=0; (int)v.size()<n; i++)
+	{
+		if (kind==0) v.push_back(rand());
+		else if (kind==1) v.push_back((i/300)&1 ? 'x' : 0);
+		else
+		{
+			int k = snprintf(line, sizeof(line), "t=%i.%02i id=%04X temp=%i.%i rh=%i%% %s\n", i/100, i%100, 0x1A2B+i%3,
+				20+rand()%3, rand()%10, 40+i%7, (rand()%5 ? "ok" : "retry"));
+			v.insert(v.end(), line, line+k);
+		}
+	}
+	v.resize(n);
+	return v;
+}
+
+TEST(LzssTest, format) {
+	// A literal then a run as one match of distance 1, then the padding
+	uint8_t out[16], back[16];
+	EXPECT_EQ(lzss_encode((const uint8_t *)"aaaaa", 5, out, sizeof(out)), 3);
+	// 1 01100001, 0 00000000 0010, 00
+	EXPECT_EQ(out[0], 0xB0);
+	EXPECT_EQ(out[1], 0x80);
+	EXPECT_EQ(out[2], 0x08);
+	EXPECT_EQ(lzss_decode(out, 3, back, sizeof(back)), 5);
+	EXPECT_EQ(memcmp(back, "aaaaa", 5), 0);
+	EXPECT_EQ(lzss_encode(out, 0, out, sizeof(out)), 0);
+	// Decoding stops at osize
+	EXPECT_EQ(lzss_decode(out, 3, back, 2), 2);
+}
+
+TEST(LzssTest, roundtrip) {
+	// In one go and in random pieces, against each other, past the positions wrapping
+	srand(47);
+	for (int kind=0; kind<3; kind++)
+	{
+		for (int n : { 1, 2, 17, 18, 255, 256, 1000, 70000 })
+		{
+			std::vector<uint8_t> in = lzss_data(kind, n), one(LZSS_ENC_SIZE(n)), enc, dec;
+			int k = lzss_encode(in.data(), n, one.data(), one.size());
+			ASSERT_LE(k, LZSS_ENC_SIZE(n));
+			one.resize(k);
+			lzss_enc e;
+			lzss_enc_init(&e);
+			for (int i=0; i<n; )
+			{
+				int m = std::min(n-i, rand()%40);
+				uint8_t buf[LZSS_ENC_SIZE(40)];
+				int j = lzss_enc_update(&e, in.data()+i, m, buf, sizeof(buf));
+				ASSERT_LE(j, LZSS_ENC_SIZE(m));
+				enc.insert(enc.end(), buf, buf+j), i += m;
+			}
+			uint8_t buf[LZSS_ENC_SIZE(0)];
+			int j = lzss_enc_final(&e, buf, sizeof(buf));
+			enc.insert(enc.end(), buf, buf+j);
+			ASSERT_EQ(enc, one) << kind << " " << n;
+			lzss_dec d;
+			lzss_dec_init(&d);
+			for (int i=0; i<k; )
+			{
+				int m = std::min(k-i, rand()%8);
+				uint8_t out[LZSS_DEC_SIZE(8)];
+				j = lzss_dec_update(&d, one.data()+i, m, out, sizeof(out));
+				ASSERT_LE(j, LZSS_DEC_SIZE(m));
+				dec.insert(dec.end(), out, out+j), i += m;
+			}
+			ASSERT_EQ(dec, in) << kind << " " << n;
+			if (kind==0) { EXPECT_LE(k, n*9/8+1); }
+			if (kind==2 && n>=1000) { EXPECT_LT(k, n/2); }
+		}
+	}
+}
@@ -1,4 +1,5 @@
 #include "main.h"
+#include <unistd.h>
 
 std::vector<char> *g_com_putc_data = nullptr;
 std::vector<char> *g_com_getc_data = nullptr;
@@ -22,6 +23,28 @@ extern "C" char com_getc()
 	return r;
 }
 
+// Runs a host tool from ../tool (cmd is its name and any options) on input, written to a temp file given as
+// its last argument, and returns what it prints, stderr included.  False if there's no python3 to run it.
+bool tool_run(const std::string &cmd, const std::vector<uint8_t> &input, std::string *output)
+{
+	char path[] = "/tmp/lillib_tool_XXXXXX", buf[256];
+	int fd;
+	size_t n;
+	output->clear();
+	if (system("python3 -c '' 2>/dev/null")) return false;
+	fd = mkstemp(path);
+	if (fd<0 || write(fd, input.data(), input.size())!=(ssize_t)input.size()) return false;
+	close(fd);
+	FILE *f = popen(("python3 -u ../tool/" + cmd + " " + path + " 2>&1").c_str(), "r");
+	if (f)
+	{
+		while ((n=fread(buf, 1, sizeof(buf), f))>0) output->append(buf, n);
+		pclose(f);
+	}
+	unlink(path);
+	return f!=nullptr;
+}
+
 TEST(main, typedefs)
 {
 	EXPECT_EQ(sizeof(int8_t), 1);
@@ -30,6 +53,8 @@ TEST(main, typedefs)
 	EXPECT_EQ(sizeof(uint8_t), 1);
 	EXPECT_EQ(sizeof(uint16_t), 2);
 	EXPECT_EQ(sizeof(uint32_t), 4);
+	EXPECT_EQ(sizeof(int64_t), 8);
+	EXPECT_EQ(sizeof(uint64_t), 8);
 }
 
 int main(int argc, char **argv)
@@ -11,3 +11,4 @@ extern "C"
 extern std::vector<char> *g_com_putc_data;
 extern std::vector<char> *g_com_getc_data;
 
+bool tool_run(const std::string &cmd, const std::vector<uint8_t> &input, std::string *output);
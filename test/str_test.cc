@@ -0,0 +1,130 @@
+#include "main.h"
+
+// All alignments and lengths around the word size, against libc
+TEST(StrTest, mem) {
+	uint8_t a[96], b[96], c[96];
+	for (int i=0; i<(int)sizeof(a); i++) a[i] = i*7+1;
+	for (int off=0; off<8; off++)
+	{
+		for (int n=0; n<=40; n++)
+		{
+			memset(b, 0xEE, sizeof(b)); memset(c, 0xEE, sizeof(c));
+			memcpy(c+off+3, a+off, n);
+			EXPECT_EQ(qmemcpy(b+off+3, a+off, n), b+off+3);
+			ASSERT_EQ(memcmp(b, c, sizeof(b)), 0) << "qmemcpy off=" << off << " n=" << n;
+			memset(c+off, 'x', n);
+			EXPECT_EQ(qmemset(b+off, 'x', n), b+off);
+			ASSERT_EQ(memcmp(b, c, sizeof(b)), 0) << "qmemset off=" << off << " n=" << n;
+			// Equal, then differing at each position either way
+			memcpy(b, a, sizeof(b));
+			EXPECT_EQ(qmemcmp(a+off, b+off, n), 0);
+			for (int i=0; i<n; i++)
+			{
+				b[off+i] = a[off+i]+1;
+				ASSERT_LT(qmemcmp(a+off, b+off, n), 0) << "off=" << off << " n=" << n << " i=" << i;
+				ASSERT_GT(qmemcmp(b+off, a+off, n), 0) << "off=" << off << " n=" << n << " i=" << i;
+				ASSERT_EQ(qmemcmp(a+off, b+off, i), 0);
+				b[off+i] = a[off+i];
+			}
+			for (int i=0; i<n+2; i++)
+			{
+				char v = (i<n ? a[off+i] : 0x80);
+				ASSERT_EQ(qmemchr(a+off, v, n), memchr(a+off, v, n)) << "off=" << off << " n=" << n << " i=" << i;
+			}
+		}
+	}
+	// Unsigned compare
+	EXPECT_GT(qmemcmp("\x80", "\x7F", 1), 0);
+	EXPECT_EQ(qmemset(b, 0, 0), b);
+	EXPECT_EQ(qmemchr(a, 1, 0), nullptr);
+}
+
+TEST(StrTest, str) {
+	// Strings ending at a page end, where reading a word past the NUL could fault
+	char *page = (char *)aligned_alloc(4096, 8192);
+	memset(page, 0, 8192);
+	for (int n=0; n<40; n++)
+	{
+		for (int end : {100, 4095})
+		{
+			char *s = page + end - n;
+			for (int i=0; i<n; i++) s[i] = 'a' + i%26;
+			s[n] = 0;
+			ASSERT_EQ(qstrlen(s), n);
+			for (char c='a'; c<='z'+1; c++) ASSERT_EQ(qstrchr(s, c), strchr(s, c)) << "n=" << n << " c=" << c;
+			ASSERT_EQ(qstrchr(s, 0), s+n);
+			ASSERT_EQ(qstrchr(s, '\xE1'), nullptr);
+			ASSERT_EQ(qstrchrnul(s, '\xE1'), s+n);
+			if (n)
+			{
+				ASSERT_EQ(qstrchrnul(s, s[n-1]), strchr(s, s[n-1]));
+			}
+			memset(s, 0, n);
+		}
+	}
+	free(page);
+}
+
+TEST(StrTest, strb) {
+	char buf[64];
+	strb b;
+	strb_init(&b, buf, sizeof(buf));
+	strb_append_fix(strb_append_str(strb_append_int(strb_append_str(&b, "x="), -42, 10, 0, ' '), " v="), 1234, 2);
+	EXPECT_STREQ(buf, "x=-42 v=12.34");
+	EXPECT_EQ(b.length, 13);
+	EXPECT_FALSE(strb_truncated(&b));
+	// Each append against the equivalent format
+	char ref[64];
+	struct { int32_t v; char radix; int8_t width; char fill; const char *fmt; } ints[] = {
+		{ 5, 10, 4, ' ', "%4i" }, { -5, 10, 4, '0', "%04i" }, { -5, 10, -4, '.', "%.<4i" }, { 255, 16, 0, ' ', "%X" },
+		{ -1, 16, 0, ' ', "%X" }, { 5, 2, 8, '0', "%08b" }, { INT32_MIN, 10, 0, ' ', "%i" }, { 123, 10, 2, ' ', "%2i" },
+	};
+	for (auto &t : ints)
+	{
+		strb_init(&b, buf, sizeof(buf));
+		strb_append_int(&b, t.v, t.radix, t.width, t.fill);
+		qsprintf(ref, sizeof(ref), t.fmt, t.v);
+		EXPECT_STREQ(buf, ref) << t.fmt;
+		EXPECT_EQ(b.length, (int)strlen(ref));
+	}
+	for (int32_t v : { 0, 1, 5, -5, 1234, -1234, 1000000, INT32_MIN, INT32_MAX })
+	{
+		for (uint8_t d : { 0, 1, 2, 3, 5, 12 })
+		{
+			strb_init(&b, buf, sizeof(buf));
+			strb_append_fix(&b, v, d);
+			qsprintf(ref, sizeof(ref), "%.*$", d, v);
+			EXPECT_STREQ(buf, ref) << v << " " << (int)d;
+		}
+	}
+	strb_init(&b, buf, sizeof(buf));
+	strb_append_hex(strb_append_hex(&b, 0xBEEF, 8), 0xA, 0);
+	EXPECT_STREQ(buf, "0000BEEFA");
+	// Truncation keeps counting, and keeps the NUL
+	strb_init(&b, buf, 8);
+	memset(buf+8, '@', 8);
+	strb_append_str(&b, "hello");
+	strb_append_int(&b, 123456, 10, 0, ' ');
+	strb_append_char(&b, '!');
+	EXPECT_STREQ(buf, "hello12");
+	EXPECT_EQ(b.length, 12);
+	EXPECT_TRUE(strb_truncated(&b));
+	EXPECT_EQ(buf[8], '@');
+	strb_init(&b, NULL, 0);
+	strb_append_str(&b, "measure");
+	EXPECT_EQ(b.length, 7);
+}
+
+TEST(StrTest, StrBuf) {
+	StrBuf<16> s;
+	s.append_str("t=").append_fix(-512, 2).append_char(' ').append_hex(0x1F, 4).append_str(FSTR("!"));
+	EXPECT_STREQ(s.c_str(), "t=-5.12 001F!");
+	EXPECT_EQ(s.len(), 13);
+	EXPECT_FALSE(s.truncated());
+	s.append_int(12345, 10, 6, '0');
+	EXPECT_STREQ(s.c_str(), "t=-5.12 001F!01");
+	EXPECT_EQ(s.len(), 19);
+	EXPECT_TRUE(s.truncated());
+	s.clear().append_int(7);
+	EXPECT_STREQ(s.c_str(), "7");
+}
@@ -0,0 +1,141 @@
+#include "main.h"
+
+static std::vector<uint8_t> tlm_record(const uint8_t *buf, int n)
+{
+	return std::vector<uint8_t>(buf, buf+(n<0 ? 0 : n));
+}
+
+TEST(TlmTest, format) {
+	tlm_enc t;
+	uint8_t buf[64];
+	tlm_init(&t);
+	tlm_begin(&t, buf, sizeof(buf));
+	tlm_fix(tlm_int(tlm_uint(&t, 1, 300), 2, -3), 3, -1234, 2);
+	tlm_bytes(&t, 20, "ab", 2);
+	EXPECT_EQ(tlm_record(buf, tlm_end(&t)), (std::vector<uint8_t>{
+		0x08, 0xAC, 0x02,           // 1<<3|UINT, 300
+		0x11, 0x05,                 // 2<<3|INT, -3 zigzagged
+		0x1A, 0x02, 0xA3, 0x13,     // 3<<3|FIX, 2 decimals, -1234 zigzagged
+		0xA3, 0x01, 0x02, 'a', 'b', // 20<<3|BYTES takes two bytes, then the length
+		0x00 }));
+	// Differences from the last values, then the values again in a key record
+	tlm_begin(&t, buf, sizeof(buf));
+	tlm_fix_delta(tlm_int_delta(&t, 2, -1), 3, -1240, 2);
+	EXPECT_EQ(tlm_record(buf, tlm_end(&t)), (std::vector<uint8_t>{ 0x15, 0x04, 0x1E, 0x02, 0x0B, 0x00 }));
+	tlm_key(&t);
+	tlm_begin(&t, buf, sizeof(buf));
+	tlm_int_delta(&t, 2, -1);
+	EXPECT_EQ(tlm_record(buf, tlm_end(&t)), (std::vector<uint8_t>{ 0x11, 0x01, 0x00 }));
+	// Ids that aren't remembered always send values
+	tlm_begin(&t, buf, sizeof(buf));
+	tlm_int_delta(&t, LILLIB_CFG_TLM_DELTA_IDS, 5);
+	EXPECT_EQ(buf[0] & TLM_DELTA, 0);
+}
+
+TEST(TlmTest, roundtrip) {
+	// Random records of every field, with and without deltas, through the decoder
+	tlm_enc t;
+	tlm_dec d;
+	tlm_field f;
+	uint8_t buf[200];
+	int32_t values[] = { 0, 1, -1, 63, -64, 64, 127, 128, -129, 300, 16383, 16384, -100000, INT32_MAX, INT32_MIN };
+	srand(50);
+	tlm_init(&t);
+	tlm_dec_init(&d);
+	for (int r=0; r<2000; r++)
+	{
+		struct Field { uint8_t id, type, decimals; int32_t v; int n; };
+		std::vector<Field> fields;
+		if (r%100==50) tlm_key(&t);
+		tlm_begin(&t, buf, sizeof(buf));
+		for (int i=rand()%8; i>0; i--)
+		{
+			Field e = { (uint8_t)(1 + rand()%(rand()%2 ? 20 : 255)), (uint8_t)(rand()%4), (uint8_t)(rand()%4),
+				(rand()%2 ? values[rand()%15] : (int32_t)(rand()*2654435761u)), rand()%12 };
+			bool delta = rand()%2;
+			switch (e.type)
+			{
+				case TLM_UINT: tlm_uint(&t, e.id, e.v); e.decimals = 0; break;
+				case TLM_INT: (delta ? tlm_int_delta : tlm_int)(&t, e.id, e.v); e.decimals = 0; break;
+				case TLM_FIX: (delta ? tlm_fix_delta(&t, e.id, e.v, e.decimals) : tlm_fix(&t, e.id, e.v, e.decimals)); break;
+				case TLM_BYTES: tlm_bytes(&t, e.id, values, e.n); e.decimals = 0; break;
+			}
+			fields.push_back(e);
+		}
+		int n = tlm_end(&t);
+		ASSERT_GT(n, 0);
+		tlm_dec_begin(&d, buf, n);
+		for (auto &e : fields)
+		{
+			ASSERT_EQ(tlm_dec_next(&d, &f), 1) << r;
+			ASSERT_EQ(f.id, e.id);
+			ASSERT_EQ(f.type, e.type);
+			ASSERT_EQ(f.decimals, e.decimals);
+			if (e.type==TLM_BYTES)
+			{
+				ASSERT_EQ(f.n, e.n);
+				ASSERT_EQ(memcmp(f.data, values, e.n), 0);
+			}
+			else ASSERT_EQ(f.v, e.v) << r << " " << (int)e.id;
+		}
+		ASSERT_EQ(tlm_dec_next(&d, &f), 0);
+		ASSERT_EQ(d.n, 0);
+	}
+}
+
+TEST(TlmTest, errors) {
+	tlm_enc t;
+	tlm_dec d;
+	tlm_field f;
+	uint8_t buf[16];
+	// A record that doesn't fit isn't written past size, and the next one is a key record
+	tlm_init(&t);
+	tlm_begin(&t, buf, 4);
+	memset(buf+4, 0xEE, sizeof(buf)-4);
+	tlm_int(tlm_int(&t, 1, 1000), 2, 2000);
+	EXPECT_EQ(tlm_end(&t), -1);
+	EXPECT_EQ(t.length, 7);
+	EXPECT_EQ(buf[4], 0xEE);
+	tlm_begin(&t, buf, sizeof(buf));
+	tlm_int_delta(&t, 1, 1001);
+	EXPECT_EQ(tlm_record(buf, tlm_end(&t)), (std::vector<uint8_t>{ 0x09, 0xD2, 0x0F, 0x00 }));
+	// Malformed records: cut short, an overlong varint, one past 32 bits, bytes past the end, id 0, and a
+	// delta UINT
+	const std::vector<uint8_t> bad[] = {
+		{ 0x09 }, { 0x09, 0x80 }, { 0x12, 0x02 }, { 0x09, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01 },
+		{ 0x08, 0xFF, 0xFF, 0xFF, 0xFF, 0x1F, 0x00 }, { 0x08, 0x80, 0x80, 0x80, 0x80, 0x70, 0x00 },
+		{ 0x1B, 0x05, 'a' }, { 0x01, 0x02 }, { 0x0C, 0x01 }, { 0x80 },
+	};
+	for (auto &b : bad)
+	{
+		tlm_dec_init(&d);
+		tlm_dec_begin(&d, b.data(), b.size());
+		EXPECT_EQ(tlm_dec_next(&d, &f), -1) << (int)b[0] << " " << b.size();
+	}
+	// While the largest 32 bit value is fine
+	const uint8_t max[] = { 0x08, 0xFF, 0xFF, 0xFF, 0xFF, 0x0F, 0x00 };
+	tlm_dec_begin(&d, max, sizeof(max));
+	EXPECT_EQ(tlm_dec_next(&d, &f), 1);
+	EXPECT_EQ((uint32_t)f.v, 0xFFFFFFFFu);
+	// A record has to end with its 0
+	tlm_dec_begin(&d, buf, 0);
+	EXPECT_EQ(tlm_dec_next(&d, &f), -1);
+}
+
+TEST(TlmTest, tool) {
+	// tool/tlm_decode.py reads what tlm.c writes, and rejects what tlm_dec_next does
+	tlm_enc t;
+	uint8_t buf[64];
+	std::vector<uint8_t> capture;
+	std::string text;
+	tlm_init(&t);
+	tlm_begin(&t, buf, sizeof(buf));
+	tlm_bytes(tlm_fix(tlm_int(tlm_uint(&t, 1, 300), 2, -3), 3, -1234, 2), 20, "ab", 2);
+	capture.insert(capture.end(), buf, buf+tlm_end(&t));
+	tlm_begin(&t, buf, sizeof(buf));
+	tlm_fix_delta(tlm_int_delta(tlm_uint(&t, 1, 0xFFFFFFFF), 2, -1), 3, -1240, 2);
+	capture.insert(capture.end(), buf, buf+tlm_end(&t));
+	capture.insert(capture.end(), { 0x08, 0xFF, 0xFF, 0xFF, 0xFF, 0x1F, 0x00 });
+	if (!tool_run("tlm_decode.py --raw", capture, &text)) GTEST_SKIP() << "no python3";
+	EXPECT_EQ(text, "1=300 2=-3 3=-12.34 20='ab'\n1=4294967295 2=-1 3=-12.40\ntlm_decode: bad varint\n");
+}
@@ -0,0 +1,193 @@
+#include "lillib.h"
+
+// Compact binary telemetry, in place of com_printf'd text: no digits to make, and a few bytes per value.
+// A record is a list of fields and then a 0.  Each field is a tag, a LEB128 varint (7 bits per byte, LSB
+// first, top bit set on all but the last) of id<<3 | delta<<2 | type, and then its value:
+//   TLM_UINT   varint
+//   TLM_INT    zigzag varint (0, -1, 1, -2... as 0, 1, 2, 3...)
+//   TLM_FIX    a decimals byte, then a zigzag varint of v, for v/10^decimals (as strb_append_fix)
+//   TLM_BYTES  varint length, then the bytes
+// Ids are 1-255, so up to 15 take a one byte tag.  With the delta bit (INT and FIX only) the value is the
+// difference from the last UINT/INT/FIX value of that id, which both ends remember for ids below
+// LILLIB_CFG_TLM_DELTA_IDS (starting from 0).  So a decoder has to see every record, and one that joins late
+// or misses one needs a key record (see tlm_key) to catch up.  Send records framed, with com_send_packet.
+
+static void tlm_put(tlm_enc *t, uint8_t c)
+{
+	if (t->length<t->size) t->buf[t->length] = c;
+	t->length++;
+}
+
+static void tlm_varint(tlm_enc *t, uint32_t v)
+{
+	for ( ; v>=0x80; v>>=7) tlm_put(t, (uint8_t)v | 0x80);
+	tlm_put(t, v);
+}
+
+#define TLM_ZIGZAG(v) ((uint32_t)(v)<<1 ^ -((uint32_t)(v)>>31))
+
+// The last value of id, replaced by v
+static int32_t tlm_prev(int32_t *prev, uint8_t id, int32_t v)
+{
+	int32_t p = 0;
+	if (id<LILLIB_CFG_TLM_DELTA_IDS) p = prev[id], prev[id] = v;
+	return p;
+}
+
+// Clears the remembered values, as a decoder starts
+void tlm_init(tlm_enc *t)
+{
+	uint8_t i;
+	for (i=0; i<LILLIB_CFG_TLM_DELTA_IDS; i++) t->prev[i] = 0;
+	t->key = 0;
+}
+
+// Makes the next record send values instead of deltas, so a decoder can start from it
+void tlm_key(tlm_enc *t)
+{
+	t->key = 1;
+}
+
+// Starts a record in buf.  Like strb, what doesn't fit isn't written but is counted in length, and the field
+// functions return t, for chaining.
+void tlm_begin(tlm_enc *t, uint8_t *buf, int size)
+{
+	t->buf = buf, t->size = size, t->length = 0;
+}
+
+tlm_enc *tlm_uint(tlm_enc *t, uint8_t id, uint32_t v)
+{
+	tlm_prev(t->prev, id, v);
+	tlm_varint(t, (uint16_t)id<<3 | TLM_UINT);
+	tlm_varint(t, v);
+	return t;
+}
+
+tlm_enc *tlm_int(tlm_enc *t, uint8_t id, int32_t v)
+{
+	tlm_prev(t->prev, id, v);
+	tlm_varint(t, (uint16_t)id<<3 | TLM_INT);
+	tlm_varint(t, TLM_ZIGZAG(v));
+	return t;
+}
+
+tlm_enc *tlm_fix(tlm_enc *t, uint8_t id, int32_t v, uint8_t decimals)
+{
+	tlm_prev(t->prev, id, v);
+	tlm_varint(t, (uint16_t)id<<3 | TLM_FIX);
+	tlm_put(t, decimals);
+	tlm_varint(t, TLM_ZIGZAG(v));
+	return t;
+}
+
+// As tlm_int/tlm_fix, but sending the difference from the last value of id (or the value itself, for a key
+// record or an id that isn't remembered), wrapping around at 32 bits
+tlm_enc *tlm_int_delta(tlm_enc *t, uint8_t id, int32_t v)
+{
+	uint32_t d;
+	if (t->key || id>=LILLIB_CFG_TLM_DELTA_IDS) return tlm_int(t, id, v);
+	d = (uint32_t)v - (uint32_t)tlm_prev(t->prev, id, v);
+	tlm_varint(t, (uint16_t)id<<3 | TLM_DELTA | TLM_INT);
+	tlm_varint(t, TLM_ZIGZAG(d));
+	return t;
+}
+
+tlm_enc *tlm_fix_delta(tlm_enc *t, uint8_t id, int32_t v, uint8_t decimals)
+{
+	uint32_t d;
+	if (t->key || id>=LILLIB_CFG_TLM_DELTA_IDS) return tlm_fix(t, id, v, decimals);
+	d = (uint32_t)v - (uint32_t)tlm_prev(t->prev, id, v);
+	tlm_varint(t, (uint16_t)id<<3 | TLM_DELTA | TLM_FIX);
+	tlm_put(t, decimals);
+	tlm_varint(t, TLM_ZIGZAG(d));
+	return t;
+}
+
+tlm_enc *tlm_bytes(tlm_enc *t, uint8_t id, const void *data, int n)
+{
+	const uint8_t *p = (const uint8_t *)data;
+	tlm_varint(t, (uint16_t)id<<3 | TLM_BYTES);
+	tlm_varint(t, n);
+	while (n-->0) tlm_put(t, *p++);
+	return t;
+}
+
+// Ends the record.  Returns its length, or -1 if it didn't fit.  Then the values it would have sent are
+// remembered anyway, so the next record is made a key record.
+int tlm_end(tlm_enc *t)
+{
+	tlm_put(t, 0);
+	if (t->length>t->size)
+	{
+		t->key = 1;
+		return -1;
+	}
+	t->key = 0;
+	return t->length;
+}
+
+void tlm_dec_init(tlm_dec *d)
+{
+	uint8_t i;
+	for (i=0; i<LILLIB_CFG_TLM_DELTA_IDS; i++) d->prev[i] = 0;
+}
+
+// Starts reading the record in buf
+void tlm_dec_begin(tlm_dec *d, const uint8_t *buf, int n)
+{
+	d->p = buf, d->n = n;
+}
+
+// A varint from the record, clearing *ok if it runs out or is too long (including a 5th byte with bits
+// above bit 31)
+static uint32_t tlm_dec_varint(tlm_dec *d, uint8_t *ok)
+{
+	uint32_t v = 0;
+	uint8_t c, s;
+	for (s=0; s<35; s+=7)
+	{
+		if (d->n<=0) break;
+		c = *d->p++, d->n--;
+		if (s==28 && (c&0x70)) break;
+		v |= (uint32_t)(c&0x7F)<<s;
+		if (!(c&0x80)) return v;
+	}
+	*ok = 0;
+	return 0;
+}
+
+// Reads the next field into f, with deltas applied.  Returns 1, or 0 at the end of the record, or -1 if it's
+// malformed.
+int tlm_dec_next(tlm_dec *d, tlm_field *f)
+{
+	uint8_t ok = 1;
+	uint32_t tag = tlm_dec_varint(d, &ok), v;
+	if (!ok || tag>>3>255) return -1;
+	if (!tag) return 0;
+	if (!(tag>>3)) return -1;
+	f->id = tag>>3, f->type = tag&3, f->decimals = 0, f->data = NULL, f->n = 0;
+	if ((tag&TLM_DELTA) && (f->type==TLM_UINT || f->type==TLM_BYTES)) return -1;
+	if (f->type==TLM_FIX)
+	{
+		if (d->n<=0) return -1;
+		f->decimals = *d->p++, d->n--;
+	}
+	v = tlm_dec_varint(d, &ok);
+	if (!ok) return -1;
+	if (f->type==TLM_BYTES)
+	{
+		if (v>(uint32_t)d->n) return -1;
+		f->data = d->p, f->n = v;
+		d->p += v, d->n -= v;
+		return 1;
+	}
+	if (f->type!=TLM_UINT) v = v>>1 ^ -(v&1);
+	if (tag&TLM_DELTA)
+	{
+		if (f->id>=LILLIB_CFG_TLM_DELTA_IDS) return -1;
+		v += d->prev[f->id];
+	}
+	f->v = v;
+	tlm_prev(d->prev, f->id, v);
+	return 1;
+}
@@ -0,0 +1,403 @@
+#!/usr/bin/env python3
+# Decodes the binary LOG() records (see log.c) in a capture of com output back into text, using the ELF
+# the firmware was built from (e.g. __builddir__/app.elf from build.sh) to look up the format strings.
+# Everything that isn't a record is passed through as is.
+#
+#   log_decode.py [--avr-float] app.elf [capture.bin]      (reads stdin if no capture is given)
+#
+# Formatting follows conv.c's strf_conv, including its quirks, for the target's type sizes and default
+# config: AVR builds leave LILLIB_CFG_CONV_FLOAT off, so show "<float?>" (--avr-float if a build turns it
+# on).  Floats are exact up to the target's digits (8 for the AVR's 32 bit doubles, 17 otherwise), as on the
+# device, but may differ in the last digit where the device's rounding isn't exact.
+# Host builds need to be linked with -no-pie so the format addresses match the ELF.
+
+import math
+import struct
+import sys
+from decimal import Decimal, localcontext, ROUND_HALF_EVEN
+
+LOG_MARKER = 0x1E
+
+
+class Arch:
+    # Type sizes and formatter limits per ELF machine
+    def __init__(self, machine, elfclass, avr_float=False):
+        if machine == 83:    # AVR
+            self.int, self.long, self.ptr, self.double = 2, 4, 2, 4
+            self.longlong = False
+            self.float = avr_float
+        else:                # ARM, x86_64
+            self.int, self.ptr, self.double = 4, (8 if elfclass == 2 else 4), 8
+            self.long = self.ptr
+            self.longlong = True
+            self.float = True
+        self.bufsize = (66 if self.longlong or self.long > 4 else 34)  # STRF_BUFSIZE
+        self.fp_digits = (17 if self.double == 8 else 8)                # STRF_FP_DIGITS
+
+
+class Elf:
+    # Just enough ELF parsing to read strings out of the loaded sections
+    def __init__(self, path, avr_float=False):
+        with open(path, 'rb') as f:
+            self.data = f.read()
+        d = self.data
+        if d[:4] != b'\x7fELF':
+            raise ValueError('%s is not an ELF file' % path)
+        self.elfclass = d[4]
+        if self.elfclass == 1:
+            shoff, = struct.unpack_from('<I', d, 0x20)
+            shentsize, shnum = struct.unpack_from('<HH', d, 0x2E)
+        else:
+            shoff, = struct.unpack_from('<Q', d, 0x28)
+            shentsize, shnum = struct.unpack_from('<HH', d, 0x3A)
+        machine, = struct.unpack_from('<H', d, 0x12)
+        self.arch = Arch(machine, self.elfclass, avr_float)
+        self.sections = []
+        for i in range(shnum):
+            o = shoff + i * shentsize
+            if self.elfclass == 1:
+                _, stype, flags, addr, offset, size = struct.unpack_from('<IIIIII', d, o)
+            else:
+                _, stype, flags, addr, offset, size = struct.unpack_from('<IIQQQQ', d, o)
+            if flags & 0x2 and stype != 8:  # SHF_ALLOC and not NOBITS
+                self.sections.append((addr, offset, size))
+
+    def string(self, addr):
+        for base, offset, size in self.sections:
+            if base <= addr < base + size:
+                start = offset + addr - base
+                end = self.data.index(b'\0', start, offset + size)
+                return self.data[start:end].decode('latin-1')
+        return None
+
+
+class Args:
+    # Reads arguments out of a record's payload.  Running out gives None, shown as "<?>".
+    def __init__(self, payload, arch):
+        self.p = payload
+        self.i = 0
+        self.arch = arch
+
+    def raw(self, n):
+        if self.i + n > len(self.p):
+            self.i = len(self.p)
+            return None
+        b = self.p[self.i:self.i + n]
+        self.i += n
+        return b
+
+    def uint(self, n):
+        b = self.raw(n)
+        return None if b is None else int.from_bytes(b, 'little')
+
+    def int(self, n):
+        b = self.raw(n)
+        return None if b is None else int.from_bytes(b, 'little', signed=True)
+
+    def double(self):
+        b = self.raw(self.arch.double)
+        return None if b is None else struct.unpack('<f' if len(b) == 4 else '<d', b)[0]
+
+    def string(self):
+        if self.i >= len(self.p):
+            return None
+        end = self.p.find(b'\0', self.i)
+        end = (len(self.p) if end < 0 else end)
+        s = self.p[self.i:end].decode('latin-1')
+        self.i = end + 1
+        return s
+
+
+def itoa(v, radix, ucase):
+    digits = '0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ' if ucase else '0123456789abcdefghijklmnopqrstuvwxyz'
+    s = ''
+    while True:
+        s = digits[v % radix] + s
+        v //= radix
+        if not v:
+            return s
+
+
+def fixdot(s, prec):
+    # strf_fixdot: zero fill to prec digits and insert the '.', with no leading 0
+    s = s.rjust(prec, '0')
+    return s[:len(s) - prec] + '.' + s[len(s) - prec:]
+
+
+def fp_round(x, q):
+    # round(x * 10^q), ties to even
+    with localcontext() as ctx:
+        ctx.prec = 2000
+        return int((x.scaleb(q)).quantize(Decimal(1), rounding=ROUND_HALF_EVEN))
+
+
+def fp_digits(x, n, k):
+    # strf_fp_digits: x to n significant digits, correcting the exponent estimate k
+    N = fp_round(x, n - 1 - k)
+    if N < 10 ** (n - 1):
+        k -= 1
+        N = fp_round(x, n - 1 - k)
+    elif N >= 10 ** n:
+        k += 1
+        N = fp_round(x, n - 1 - k)
+    if N >= 10 ** n:
+        k += 1
+        N //= 10
+    return N, k
+
+
+def ftoa(v, typ, prec, arch):
+    # strf_ftoa, returns (sign, content)
+    ucase = typ.isupper()
+    typ = typ.lower()
+    sign = ('-' if math.copysign(1.0, v) < 0 else '')
+    if math.isinf(v) or math.isnan(v):
+        s = ('nan' if math.isnan(v) else 'inf')
+        return sign, (s.upper() if ucase else s)
+    ax = abs(v)
+    x = Decimal(ax)
+    DIG, BUF = arch.fp_digits, arch.bufsize
+    k = (((math.frexp(ax)[1] - 1) * 78913) >> 18 if ax else 0)
+    if prec < 0:
+        prec = 6
+    strip = False
+    o = ''
+    if typ == 'g':
+        if not prec:
+            prec = 1
+        if ax:
+            _, k = fp_digits(x, min(prec, DIG), k)
+        if k < -4 or k >= prec:
+            typ, prec = 'e', prec - 1
+        else:
+            typ, prec = 'f', prec - 1 - k
+        strip = True
+    if typ == 'f':
+        if not ax or k + 1 + prec <= DIG:
+            N, kk = (fp_round(x, prec) if ax else 0), -prec
+        else:
+            N, k = fp_digits(x, DIG, k)
+            kk = k - DIG + 1
+        d = str(N)
+        nd = len(d)
+        kk += nd - 1
+        m = max(kk, 0)
+        if m + 2 > BUF - 1:
+            typ = 'e'
+        else:
+            if m + 2 + prec > BUF - 1:
+                prec = BUF - 1 - m - 2
+            while m >= -prec:
+                if m == -1:
+                    o += '.'
+                i = kk - m
+                o += (d[i] if 0 <= i < nd else '0')
+                m -= 1
+    if typ == 'e':
+        if prec > BUF - 1 - 8:
+            prec = BUF - 1 - 8
+        nd = min(prec + 1, DIG)
+        N, k = (fp_digits(x, nd, k) if ax else (0, k))
+        d = str(N)
+        o = d[0] + ('.' if prec else '')
+        o += ''.join((d[i] if i < nd and ax else '0') for i in range(1, prec + 1))
+    if strip and prec:
+        o = o.rstrip('0')
+        if o.endswith('.'):
+            o = o[:-1]
+    if typ == 'e':
+        if not ax:
+            k = 0
+        o += ('E' if ucase else 'e') + ('-' if k < 0 else '+')
+        o += ('%02d' % abs(k))
+    return sign, o
+
+
+def conv(fmt, i, args, elf):
+    # strf_conv: formats the spec at fmt[i] (just past the '%'), returns (text, i past the spec)
+    arch = elf.arch
+    c = lambda j: (fmt[j] if j < len(fmt) else '\0')
+    fill, align, sign, size, prec, width = ' ', '>', '', '', -1, -1
+    if c(i) != '\0' and c(i + 1) in '-<>=^':
+        fill, align = c(i), c(i + 1)
+        i += 2
+    elif c(i) in '-<>=^':
+        align = c(i)
+        i += 1
+    if c(i) in '+ ':
+        sign = c(i)
+        i += 1
+    if c(i) == '0':
+        fill, align = '0', '='
+        i += 1
+    if c(i).isdigit():
+        j = i
+        while c(i).isdigit():
+            i += 1
+        width = int(fmt[j:i])
+    elif c(i) == '*':
+        width = args.int(arch.int)
+        width = (-1 if width is None else width)
+        i += 1
+    if c(i) == '.' and c(i + 1).isdigit():
+        j = i = i + 1
+        while c(i).isdigit():
+            i += 1
+        prec = int(fmt[j:i])
+    elif c(i) == '.' and c(i + 1) == '*':
+        prec = args.int(arch.int)
+        prec = (-1 if prec is None else prec)
+        i += 2
+    elif c(i) == '.':
+        prec = 0
+        i += 1
+    if c(i) in 'hl' and c(i) != '\0':
+        size = (c(i).upper() if c(i + 1) == c(i) else c(i))
+        i += (2 if c(i + 1) == c(i) else 1)
+    typ = c(i)
+    i += 1
+    content = None
+    if typ in 'diuxXobp$':
+        signed = typ in 'di$'
+        n = {'H': 1, 'h': 2, 'l': arch.long, 'L': 8}.get(size, arch.int)
+        v = (args.int(n) if signed else args.uint(n))
+        if v is None:
+            pass
+        else:
+            if size == 'L' and not arch.longlong:
+                content = '<ll?>'
+            else:
+                radix = {'x': 16, 'X': 16, 'p': 16, 'o': 8, 'b': 2}.get(typ, 10)
+                if v < 0:
+                    sign, v = '-', -v
+                content = itoa(v, radix, typ in 'Xp')
+            if typ == '$':
+                # Even on the "<ll?>", as the device does
+                prec = (2 if prec < 0 else min(prec, 32))
+                content = fixdot(content, prec)
+    elif typ in 'kK':
+        v = args.uint(4)
+        if v is not None:
+            p10 = 10 ** (4 if prec < 0 else min(prec, 4))
+            prec = (4 if prec < 0 else min(prec, 4))
+            if typ == 'k' and v & 0x80000000:
+                sign, v = '-', (-v) & 0xFFFFFFFF
+            v = ((v >> 16) * p10 + (((v & 0xFFFF) * p10 + 0x8000) >> 16)) & 0xFFFFFFFF
+            content = fixdot(itoa(v, 10, False), prec)
+    elif typ in 'fFeEgGaA':
+        v = args.double()
+        if v is not None:
+            if typ in 'aA' or not arch.float:
+                content = '<float?>'
+            else:
+                fsign, content = ftoa(v, typ, prec, arch)
+                sign = fsign or sign
+    elif typ == 's':
+        content = args.string()
+        sign = ''
+        if content is not None and 0 <= prec < len(content):
+            content = content[:prec]
+    elif typ == 'S':
+        a = args.uint(arch.ptr)
+        sign = ''
+        if a is not None:
+            content = elf.string(a)
+            content = ('<S?>' if content is None else content)
+            if 0 <= prec < len(content):
+                content = content[:prec]
+    elif typ == 'c':
+        v = args.uint(1)
+        sign = ''
+        if v is not None:
+            content = (chr(v) if v else '')
+    elif typ == '%':
+        content = '%'
+    elif typ == '\0':
+        content = '%?'
+        i -= 1
+    else:
+        content = '%' + typ
+    if content is None:
+        content, sign = '<?>', ''
+    # Padding
+    length = len(content) + (1 if sign else 0)
+    lpad = cpad = rpad = 0
+    if length < width:
+        if align in '<-':
+            rpad = width - length
+        if align == '=':
+            cpad = width - length
+        if align == '>':
+            lpad = width - length
+        if align == '^':
+            lpad = (width - length) // 2
+            rpad = width - length - lpad
+    return fill * lpad + sign + fill * cpad + content + fill * rpad, i
+
+
+def decode_record(payload, elf):
+    args = Args(payload, elf.arch)
+    addr = args.uint(elf.arch.ptr)
+    fmt = (None if addr is None else elf.string(addr))
+    if fmt is None:
+        return '<LOG? %s>' % payload.hex()
+    out = ''
+    i = 0
+    while i < len(fmt):
+        if fmt[i] != '%':
+            out += fmt[i]
+            i += 1
+        else:
+            s, i = conv(fmt, i + 1, args, elf)
+            out += s
+    return out
+
+
+def decode_stream(data, elf):
+    # Yields text, with records replaced by their formatted text
+    i = 0
+    text = bytearray()
+    while i < len(data):
+        if data[i] != LOG_MARKER or i + 1 >= len(data) or i + 2 + data[i + 1] > len(data):
+            text.append(data[i])
+            i += 1
+            continue
+        n = data[i + 1]
+        payload = bytearray()
+        acc = bits = 0
+        for b in data[i + 2:i + 2 + n]:
+            acc |= (b & 0x7F) << bits
+            bits += 7
+            if bits >= 8:
+                payload.append(acc & 0xFF)
+                acc >>= 8
+                bits -= 8
+        if text:
+            yield text.decode('latin-1')
+            text = bytearray()
+        yield decode_record(bytes(payload), elf)
+        i += 2 + n
+    if text:
+        yield text.decode('latin-1')
+
+
+def main():
+    argv = sys.argv[1:]
+    avr_float = ('--avr-float' in argv)
+    argv = [a for a in argv if a != '--avr-float']
+    if len(argv) < 1:
+        print('usage: %s [--avr-float] app.elf [capture.bin]' % sys.argv[0], file=sys.stderr)
+        return 1
+    elf = Elf(argv[0], avr_float)
+    if len(argv) > 1:
+        with open(argv[1], 'rb') as f:
+            data = f.read()
+    else:
+        data = sys.stdin.buffer.read()
+    for s in decode_stream(data, elf):
+        sys.stdout.write(s)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
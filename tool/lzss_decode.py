@@ -0,0 +1,71 @@
+#!/usr/bin/env python3
+# Decompresses an LZSS stream (see lzss.c) from a node, e.g. a capture of com output, for the gateway.  The
+# window and length bits must match the node's LILLIB_CFG_LZSS_WINDOW_BITS and LILLIB_CFG_LZSS_LENGTH_BITS.
+# Decodes as it reads, so can sit at the end of a pipe.
+#
+#   lzss_decode.py [-w window_bits] [-l length_bits] [capture.bin]      (reads stdin if no capture is given)
+
+import argparse
+import sys
+
+MIN_MATCH = 2
+
+
+class Decoder:
+    def __init__(self, window_bits=8, length_bits=4):
+        self.wbits, self.lbits = window_bits, length_bits
+        self.match_bits = 1 + window_bits + length_bits
+        self.ring = bytearray(1 << window_bits)
+        self.mask = (1 << window_bits) - 1
+        self.pos = 0
+        self.acc = 0
+        self.nacc = 0
+
+    def update(self, data):
+        # The bytes data decodes to, keeping any partial token for next time
+        out = bytearray()
+        ring, mask = self.ring, self.mask
+        for b in data:
+            self.acc = self.acc << 8 | b
+            self.nacc += 8
+            while True:
+                top = self.acc >> (self.nacc - 1) & 1 if self.nacc else 0
+                if top and self.nacc >= 9:
+                    self.nacc -= 9
+                    c = self.acc >> self.nacc & 0xFF
+                    ring[self.pos & mask] = c
+                    self.pos += 1
+                    out.append(c)
+                elif not top and self.nacc >= self.match_bits:
+                    self.nacc -= self.match_bits
+                    d = (self.acc >> (self.nacc + self.lbits) & mask) + 1
+                    n = (self.acc >> self.nacc & ((1 << self.lbits) - 1)) + MIN_MATCH
+                    for _ in range(n):
+                        c = ring[(self.pos - d) & mask]
+                        ring[self.pos & mask] = c
+                        self.pos += 1
+                        out.append(c)
+                else:
+                    break
+            self.acc &= (1 << self.nacc) - 1
+        return bytes(out)
+
+
+def main():
+    p = argparse.ArgumentParser(description='Decompress an LZSS stream from lzss.c')
+    p.add_argument('-w', type=int, default=8, help='window bits (LILLIB_CFG_LZSS_WINDOW_BITS)')
+    p.add_argument('-l', type=int, default=4, help='length bits (LILLIB_CFG_LZSS_LENGTH_BITS)')
+    p.add_argument('capture', nargs='?')
+    args = p.parse_args()
+    f = open(args.capture, 'rb') if args.capture else sys.stdin.buffer
+    d = Decoder(args.w, args.l)
+    while True:
+        data = f.read1(4096) if hasattr(f, 'read1') else f.read(4096)
+        if not data:
+            break
+        sys.stdout.buffer.write(d.update(data))
+        sys.stdout.buffer.flush()
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+# Decodes binary telemetry records (see tlm.c) from a capture of com output into text, one line per record,
+# as "id=value" fields.  Records are read from COBS frames, as com_send_packet sends them, or back to back
+# with --raw.  Anything that doesn't decode is reported on stderr and skipped.
+#
+#   tlm_decode.py [--raw] [--delta-ids N] [capture.bin]      (reads stdin if no capture is given)
+#
+# --delta-ids must match the node's LILLIB_CFG_TLM_DELTA_IDS.
+
+import argparse
+import sys
+
+TLM_UINT, TLM_INT, TLM_FIX, TLM_BYTES = range(4)
+TLM_DELTA = 0x04
+
+
+class Malformed(Exception):
+    pass
+
+
+def cobs_decode(frame):
+    out = bytearray()
+    i = 0
+    while i < len(frame):
+        code = frame[i]
+        if code == 0 or i + code > len(frame):
+            raise Malformed('bad COBS frame')
+        out += frame[i + 1:i + code]
+        i += code
+        if code < 255 and i < len(frame):
+            out.append(0)
+    return bytes(out)
+
+
+class Decoder:
+    def __init__(self, delta_ids=16):
+        self.delta_ids = delta_ids
+        self.prev = [0] * delta_ids
+
+    def varint(self, p, i):
+        v = 0
+        for s in range(0, 35, 7):
+            if i >= len(p):
+                break
+            c = p[i]
+            i += 1
+            if s == 28 and c & 0x70:
+                break  # Bits above bit 31
+            v |= (c & 0x7F) << s
+            if not c & 0x80:
+                return v, i
+        raise Malformed('bad varint')
+
+    def record(self, p, i=0):
+        # The fields of the record at p[i], as (id, text) pairs, and where it ends
+        fields = []
+        while True:
+            tag, i = self.varint(p, i)
+            if not tag:
+                return fields, i
+            fid, typ, delta = tag >> 3, tag & 3, tag & TLM_DELTA
+            if not fid or fid > 255 or (delta and typ in (TLM_UINT, TLM_BYTES)):
+                raise Malformed('bad tag %#x' % tag)
+            decimals = 0
+            if typ == TLM_FIX:
+                if i >= len(p):
+                    raise Malformed('cut short')
+                decimals = p[i]
+                i += 1
+            v, i = self.varint(p, i)
+            if typ == TLM_BYTES:
+                if i + v > len(p):
+                    raise Malformed('cut short')
+                b = p[i:i + v]
+                i += v
+                text = (repr(b.decode('ascii')) if all(32 <= c < 127 for c in b) else b.hex())
+                fields.append((fid, text))
+                continue
+            if typ != TLM_UINT:
+                v = v >> 1 ^ -(v & 1)
+            if delta:
+                if fid >= self.delta_ids:
+                    raise Malformed('delta for id %i' % fid)
+                v += self.prev[fid]
+            v = (v + 2**31) % 2**32 - 2**31 if typ != TLM_UINT else v & 0xFFFFFFFF
+            if fid < self.delta_ids:
+                self.prev[fid] = v
+            if typ == TLM_FIX:
+                s = str(abs(v)).rjust(decimals + 1, '0')
+                text = ('-' if v < 0 else '') + s[:len(s) - decimals] + '.' + s[len(s) - decimals:]
+            else:
+                text = str(v)
+            fields.append((fid, text))
+
+
+def main():
+    p = argparse.ArgumentParser(description='Decode binary telemetry records from tlm.c')
+    p.add_argument('--raw', action='store_true', help='records back to back, not in COBS frames')
+    p.add_argument('--delta-ids', type=int, default=16, help='LILLIB_CFG_TLM_DELTA_IDS')
+    p.add_argument('capture', nargs='?')
+    args = p.parse_args()
+    data = (open(args.capture, 'rb') if args.capture else sys.stdin.buffer).read()
+    d = Decoder(args.delta_ids)
+    # With frames, any partial one at the end is left out
+    chunks = [data] if args.raw else data.split(b'\0')[:-1]
+    for chunk in chunks:
+        i = 0
+        try:
+            if not args.raw:
+                chunk = cobs_decode(chunk)
+            while i < len(chunk):
+                fields, i = d.record(chunk, i)
+                print(' '.join('%i=%s' % f for f in fields))
+        except Malformed as e:
+            print('tlm_decode: %s' % e, file=sys.stderr)
+
+
+if __name__ == '__main__':
+    main()